@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+#include "AsyncDatabase.hpp"
+#include "Benchmark.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(async_writes) {
+    const std::size_t threads =
+        std::max(2u, std::thread::hardware_concurrency());
+    for (bool group_commit : {false, true}) {
+        std::string uri = ResetDatabaseFile(context);
+        AsyncOptions async_options;
+        async_options.group_commit = group_commit;
+        AsyncDatabase db(uri, context.Options(), async_options);
+        // Every submitter keeps its writes in flight and waits at the end
+        std::vector<std::thread> submitters;
+        Stopwatch watch;
+        for (std::size_t t = 0; t < threads; t++) {
+            submitters.emplace_back([&, t]() {
+                std::vector<std::future<void>> pending;
+                for (std::size_t j = t; j < context.iterations; j += threads) {
+                    pending.push_back(db.AddRecord(MakeRecord(j)));
+                }
+                for (auto &future : pending) {
+                    future.get();
+                }
+            });
+        }
+        for (auto &submitter : submitters) {
+            submitter.join();
+        }
+        Report(std::string("AddRecord, ") + std::to_string(threads) +
+                   " submitters, group commit " +
+                   (group_commit ? "on" : "off"),
+               context.iterations, watch.Seconds());
+    }
+}
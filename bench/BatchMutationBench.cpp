@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(batch_mutations) {
+    Database db(ResetDatabaseFile(context), context.Options());
+    LoadDataset(db, context.rows);
+    // One commit per row, bounded since it syncs every row
+    const std::size_t single = std::min<std::size_t>(context.rows / 2, 500);
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < single; i++) {
+            db.UpdateRecord(static_cast<int>(i) + 1, MakeRecord(i + 1));
+        }
+        Report("UpdateRecord (one transaction per row)", single,
+               watch.Seconds());
+    }
+    {
+        std::vector<std::pair<int, Record>> updates;
+        for (std::size_t i = 0; i < context.rows; i++) {
+            updates.emplace_back(static_cast<int>(i) + 1, MakeRecord(i + 1));
+        }
+        Stopwatch watch;
+        db.UpdateRecords(updates);
+        Report("UpdateRecords", updates.size(), watch.Seconds());
+    }
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < single; i++) {
+            db.DeleteRecord(static_cast<int>(i) + 1);
+        }
+        Report("DeleteRecord (one transaction per row)", single,
+               watch.Seconds());
+    }
+    {
+        std::vector<int> rowids;
+        for (std::size_t i = single; i < context.rows; i++) {
+            rowids.push_back(static_cast<int>(i) + 1);
+        }
+        Stopwatch watch;
+        db.DeleteRecords(rowids);
+        Report("DeleteRecords", rowids.size(), watch.Seconds());
+    }
+}
@@ -0,0 +1,308 @@
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include "Database.hpp"
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace AddressBook {
+namespace Bench {
+namespace {
+/**
+ * @brief One line of the report, also written to the JSON output
+ */
+struct Result {
+    std::string benchmark;
+    std::string name;
+    std::size_t ops;
+    double seconds;
+    double p50_seconds;  // 0 if the latencies were not recorded
+    double p99_seconds;
+    std::size_t bytes;  // The size measured by ReportBytes, else 0
+    std::size_t peak_rss_bytes;
+};
+
+std::map<std::string, BenchmarkFunction> &Registry() {
+    static std::map<std::string, BenchmarkFunction> registry;
+    return registry;
+}
+
+std::vector<Result> &Results() {
+    static std::vector<Result> results;
+    return results;
+}
+
+std::string &CurrentBenchmark() {
+    static std::string name;
+    return name;
+}
+
+void AddResult(const std::string &name, std::size_t ops, double seconds,
+               double p50, double p99) {
+    Result result{CurrentBenchmark(), name, ops, seconds, p50, p99, 0,
+                  PeakRssBytes()};
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(12) << ops << " ops " << std::setw(14)
+              << std::fixed << std::setprecision(0)
+              << (seconds > 0 ? ops / seconds : 0.0) << " ops/sec";
+    if (p99 > 0) {
+        std::cout << std::setprecision(2) << "  p50 " << std::setw(9)
+                  << p50 * 1e6 << " us  p99 " << std::setw(9) << p99 * 1e6
+                  << " us";
+    }
+    std::cout << "  rss " << result.peak_rss_bytes / (1024 * 1024) << " MiB\n";
+    Results().push_back(result);
+}
+
+std::string JsonString(const std::string &text) {
+    std::string quoted("\"");
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+/**
+ * @brief Writes the results as a JSON document that can be diffed or
+ * compared across commits
+ */
+void WriteJson(const std::string &path, const Context &context,
+               const std::string &label) {
+    std::ofstream out(path);
+    out << std::setprecision(9);
+    out << "{\n  \"label\": " << JsonString(label)
+        << ",\n  \"rows\": " << context.rows
+        << ",\n  \"iterations\": " << context.iterations
+        << ",\n  \"preset\": " << JsonString(context.preset)
+        << ",\n  \"results\": [";
+    const char *separator = "\n";
+    for (const auto &result : Results()) {
+        out << separator << "    {\"benchmark\": "
+            << JsonString(result.benchmark)
+            << ", \"name\": " << JsonString(result.name)
+            << ", \"ops\": " << result.ops
+            << ", \"seconds\": " << result.seconds << ", \"ops_per_sec\": "
+            << (result.seconds > 0 ? result.ops / result.seconds : 0)
+            << ", \"p50_us\": " << result.p50_seconds * 1e6
+            << ", \"p99_us\": " << result.p99_seconds * 1e6
+            << ", \"bytes\": " << result.bytes
+            << ", \"peak_rss_bytes\": " << result.peak_rss_bytes << "}";
+        separator = ",\n";
+    }
+    out << "\n  ]\n}\n";
+}
+}  // namespace
+
+Registration::Registration(const std::string &name,
+                           BenchmarkFunction function) {
+    Registry()[name] = std::move(function);
+}
+
+/**
+ * @return DatabaseOptions The options of the preset of the run
+ */
+DatabaseOptions Context::Options() const {
+    return DatabaseOptions::FromPreset(this->preset);
+}
+
+LatencyRecorder::LatencyRecorder(std::size_t expected_ops) {
+    this->samples.reserve(expected_ops);
+}
+
+std::size_t LatencyRecorder::Ops() const {
+    return this->samples.size();
+}
+
+double LatencyRecorder::TotalSeconds() const {
+    return std::accumulate(this->samples.begin(), this->samples.end(), 0.0);
+}
+
+/**
+ * @brief Returns the `p`-th percentile latency in seconds (nearest rank)
+ * @param p The percentile, between 0 and 100
+ */
+double LatencyRecorder::Percentile(double p) const {
+    if (this->samples.empty()) {
+        return 0;
+    }
+    std::sort(this->samples.begin(), this->samples.end());
+    std::size_t rank = static_cast<std::size_t>(
+        p / 100 * static_cast<double>(this->samples.size() - 1) + 0.5);
+    return this->samples[rank];
+}
+
+/**
+ * @brief Generates the `i`-th contact of the synthetic dataset.
+ * The same `i` always yields the same record.
+ */
+Record MakeRecord(std::size_t i) {
+    static const char *const first_names[] = {
+        "Vivian", "Peter", "Oscar", "Andy", "Jacky", "Mary", "John", "Wing"};
+    static const char *const domains[] = {
+        "gmail.com", "yahoo.com.hk", "outlook.com", "example.org"};
+    Record record;
+    record.first_name = first_names[i % 8];
+    record.last_name = "Last" + std::to_string(i);
+    record.email = "user" + std::to_string(i) + "@" + domains[i % 4];
+    record.telephone = std::to_string(20000000 + i % 80000000);
+    return record;
+}
+
+/**
+ * @brief Adds the records 0 to `rows` - 1 of the synthetic dataset
+ * @return The number of records added
+ */
+std::size_t LoadDataset(Database &db, std::size_t rows) {
+    std::size_t i = 0;
+    return db.AddRecords([&](Record &record) {
+        if (i == rows) {
+            return false;
+        }
+        record = MakeRecord(i++);
+        return true;
+    });
+}
+
+/**
+ * @brief The dataset sizes of a scaling benchmark: powers of ten from
+ * 10^3 up to the rows of the context
+ */
+std::vector<std::size_t> DatasetSizes(const Context &context) {
+    std::vector<std::size_t> sizes;
+    for (std::size_t rows = 1000; rows <= context.rows; rows *= 10) {
+        sizes.push_back(rows);
+    }
+    if (sizes.empty()) {
+        sizes.push_back(context.rows);
+    }
+    return sizes;
+}
+
+/**
+ * @brief Removes the scratch database of the context and its journals
+ * @return The URI to open the fresh database with
+ */
+std::string ResetDatabaseFile(const Context &context) {
+    for (const char *suffix : {"", "-journal", "-wal", "-shm"}) {
+        std::remove((context.db_path + suffix).c_str());
+    }
+    return "file:" + context.db_path;
+}
+
+/**
+ * @return std::size_t The peak resident set size of the process so far
+ */
+std::size_t PeakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                             sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/**
+ * @brief Prints and records the throughput of a measured loop
+ */
+void Report(const std::string &name, std::size_t ops, double seconds) {
+    AddResult(name, ops, seconds, 0, 0);
+}
+
+/**
+ * @brief Prints and records the throughput and the p50 and p99 latency of
+ * a measured loop
+ */
+void Report(const std::string &name, const LatencyRecorder &latencies) {
+    AddResult(name, latencies.Ops(), latencies.TotalSeconds(),
+              latencies.Percentile(50), latencies.Percentile(99));
+}
+
+/**
+ * @brief Prints and records a size, such as that of a database file
+ */
+void ReportBytes(const std::string &name, std::size_t bytes) {
+    Result result{CurrentBenchmark(), name, 0, 0, 0, 0, bytes, PeakRssBytes()};
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(12) << bytes << " bytes  rss "
+              << result.peak_rss_bytes / (1024 * 1024) << " MiB\n";
+    Results().push_back(result);
+}
+}  // namespace Bench
+}  // namespace AddressBook
+
+/**
+ * Usage: address-book-bench [--rows N] [--iterations N] [--db PATH]
+ *                           [--preset NAME] [--json PATH] [--label TEXT]
+ *                           [filter]
+ * Runs every registered benchmark whose name contains `filter`, and writes
+ * the results to PATH as JSON if --json is given. A benchmark throwing an
+ * exception, such as a failed check, fails the run with exit code 1.
+ */
+int main(int argc, char **argv) {
+    using namespace AddressBook::Bench;
+    Context context;
+    std::string filter;
+    std::string json_path;
+    std::string label;
+    bool failed = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            context.rows = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            context.iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
+            context.db_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--preset") == 0 && i + 1 < argc) {
+            context.preset = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+    for (const auto &entry : Registry()) {
+        if (entry.first.find(filter) == std::string::npos) {
+            continue;
+        }
+        std::cout << "== " << entry.first << " (" << context.rows
+                  << " rows)" << std::endl;
+        CurrentBenchmark() = entry.first;
+        try {
+            entry.second(context);
+        } catch (const std::exception &e) {
+            std::cerr << entry.first << " failed: " << e.what() << std::endl;
+            failed = true;
+        }
+    }
+    ResetDatabaseFile(context);
+    if (!json_path.empty()) {
+        WriteJson(json_path, context, label);
+    }
+    return failed ? 1 : 0;
+}
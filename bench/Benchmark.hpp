@@ -0,0 +1,100 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DatabaseOptions.hpp"
+#include "Record.hpp"
+
+namespace AddressBook {
+class Database;
+
+namespace Bench {
+/**
+ * @brief The settings shared by every benchmark of a run
+ */
+struct Context {
+    std::size_t rows = 10000;       // Rows in the (largest) synthetic dataset
+    std::size_t iterations = 10000;  // Operations per measured loop
+    std::string db_path = "bench.db";  // Scratch database file
+    std::string preset = "default";  // DatabaseOptions preset of the suite
+    DatabaseOptions Options() const;
+};
+
+using BenchmarkFunction = std::function<void(const Context &)>;
+
+/**
+ * @brief Registers a benchmark at static initialisation time.
+ */
+struct Registration {
+    Registration(const std::string &name, BenchmarkFunction function);
+};
+
+/**
+ * @brief A steady-clock stopwatch started on construction
+ */
+class Stopwatch {
+   public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+    double Seconds() const {
+        return std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - this->start)
+            .count();
+    }
+
+   private:
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Collects the latency of every operation of a measured loop
+ */
+class LatencyRecorder {
+   public:
+    explicit LatencyRecorder(std::size_t expected_ops = 0);
+    /**
+     * @brief Runs and times one operation
+     */
+    template <typename Operation>
+    void Measure(Operation &&operation) {
+        Stopwatch watch;
+        operation();
+        this->samples.push_back(watch.Seconds());
+    }
+    std::size_t Ops() const;
+    double TotalSeconds() const;
+    double Percentile(double p) const;
+
+   private:
+    mutable std::vector<double> samples;  // Seconds, sorted on demand
+};
+
+Record MakeRecord(std::size_t i);
+std::size_t LoadDataset(Database &db, std::size_t rows);
+std::vector<std::size_t> DatasetSizes(const Context &context);
+std::string ResetDatabaseFile(const Context &context);
+std::size_t PeakRssBytes();
+void Report(const std::string &name, std::size_t ops, double seconds);
+void Report(const std::string &name, const LatencyRecorder &latencies);
+void ReportBytes(const std::string &name, std::size_t bytes);
+}  // namespace Bench
+}  // namespace AddressBook
+
+#define AB_BENCH_CONCAT_(a, b) a##b
+#define AB_BENCH_CONCAT(a, b) AB_BENCH_CONCAT_(a, b)
+/**
+ * @brief Defines and registers a benchmark named `name`.
+ */
+#define AB_BENCHMARK(name)                                                 \
+    static void AB_BENCH_CONCAT(bench_, name)(                             \
+        const AddressBook::Bench::Context &);                              \
+    static AddressBook::Bench::Registration AB_BENCH_CONCAT(               \
+        bench_registration_, name)(#name, &AB_BENCH_CONCAT(bench_, name)); \
+    static void AB_BENCH_CONCAT(bench_, name)(                             \
+        const AddressBook::Bench::Context &context)
+
+#endif  // BENCHMARK_HPP
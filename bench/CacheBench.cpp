@@ -0,0 +1,32 @@
+#include <algorithm>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(record_cache) {
+    Database db(ResetDatabaseFile(context));
+    LoadDataset(db, context.rows);
+    // Lookups skewed towards a hot tenth of the table
+    std::vector<Record> lookups;
+    for (std::size_t j = 0; j < context.iterations; j++) {
+        std::size_t hot = std::max<std::size_t>(context.rows / 10, 1);
+        lookups.push_back(MakeRecord(j % 20 == 0 ? j * 7919 % context.rows
+                                                 : j * 7919 % hot));
+    }
+    for (bool cached : {false, true}) {
+        if (cached) {
+            db.EnableCache(16 * 1024 * 1024);
+        }
+        Stopwatch watch;
+        for (const auto &record : lookups) {
+            db.GetRecordByName(record.first_name, record.last_name);
+        }
+        Report(cached ? "GetRecordByName (cache)" : "GetRecordByName (no cache)",
+               lookups.size(), watch.Seconds());
+    }
+    CacheStats stats = db.GetCacheStats();
+    std::cout << "cache hits " << stats.hits << ", misses " << stats.misses
+              << ", " << stats.bytes << " bytes" << std::endl;
+}
@@ -0,0 +1,40 @@
+#include <algorithm>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(change_feed) {
+    Database db(ResetDatabaseFile(context), context.Options());
+    LoadDataset(db, context.rows);
+    // A mirror that synced before the updates only reads what changed
+    std::int64_t synced = db.LatestChange();
+    const std::size_t updates = std::min(context.iterations, context.rows);
+    std::vector<std::pair<int, Record>> changes;
+    for (std::size_t i = 0; i < updates; i++) {
+        std::size_t row = i * 7919 % context.rows;
+        Record record = MakeRecord(row);
+        record.telephone = "0";
+        changes.emplace_back(static_cast<int>(row) + 1, record);
+    }
+    Stopwatch watch;
+    db.UpdateRecords(changes);
+    Report("UpdateRecords, logged to the change feed", updates,
+           watch.Seconds());
+    watch = Stopwatch();
+    std::size_t read = 0;
+    while (true) {
+        auto page = db.ChangesSince(synced, 1000);
+        read += page.size();
+        if (page.size() < 1000) {
+            break;
+        }
+        synced = page.back().sequence;
+    }
+    Report("ChangesSince, " + std::to_string(updates) + " changes", read,
+           watch.Seconds());
+    watch = Stopwatch();
+    std::size_t rows = db.GetAllRecords().size();
+    Report("GetAllRecords, to diff instead", rows, watch.Seconds());
+}
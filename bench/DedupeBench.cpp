@@ -0,0 +1,67 @@
+#include <cctype>
+#include <cstdint>
+#include "Benchmark.hpp"
+#include "Dedupe.hpp"
+#include "RecordBatch.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+namespace {
+/**
+ * @brief A record with pseudo-random names and telephone, unlike
+ * MakeRecord whose records differ in a few digits and so look alike
+ */
+Record MakeDistinctRecord(std::size_t i) {
+    std::uint64_t state = i * 0x9e3779b97f4a7c15ULL + 1;
+    auto next = [&](std::size_t n) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::size_t>((state >> 33) % n);
+    };
+    auto word = [&](std::size_t length) {
+        std::string text(1, static_cast<char>('A' + next(26)));
+        for (std::size_t j = 1; j < length; j++) {
+            text.push_back(static_cast<char>('a' + next(26)));
+        }
+        return text;
+    };
+    Record record = MakeRecord(i);
+    record.first_name = word(4 + next(5));
+    record.last_name = word(5 + next(6));
+    record.email = record.first_name + "." + record.last_name +
+                   record.email.substr(record.email.find('@'));
+    record.telephone = std::to_string(20000000 + next(80000000));
+    return record;
+}
+}  // namespace
+
+AB_BENCHMARK(dedupe) {
+    for (std::size_t rows : DatasetSizes(context)) {
+        // Every tenth record has a near-duplicate with a changed case and
+        // a typo in the last name
+        RecordBatch records;
+        for (std::size_t i = 0; i < rows; i++) {
+            Record record = MakeDistinctRecord(i);
+            record.id = static_cast<int>(records.Size() + 1);
+            records.Append(record);
+            if (i % 10 == 0) {
+                record.id++;
+                record.first_name[0] = static_cast<char>(
+                    std::tolower(static_cast<unsigned char>(record.first_name[0])));
+                record.last_name[1] = 'e';
+                records.Append(record);
+            }
+        }
+        for (std::size_t threads : {std::size_t(1), std::size_t(0)}) {
+            DedupeOptions options;
+            options.threads = threads;
+            Stopwatch watch;
+            std::size_t found = FindDuplicates(records, options).size();
+            Report("FindDuplicates, " + std::to_string(records.Size()) +
+                       " records, " +
+                       (threads == 1 ? "1 thread" : "all cores") + ", " +
+                       std::to_string(found) + " pairs",
+                   records.Size(), watch.Seconds());
+        }
+    }
+}
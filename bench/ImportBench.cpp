@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <sstream>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+#include "RecordImporter.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(import) {
+    // AddRecord commits, and syncs, once per row
+    {
+        Database db(ResetDatabaseFile(context));
+        std::size_t n = std::min<std::size_t>(context.rows, 200);
+        Stopwatch watch;
+        for (std::size_t i = 0; i < n; i++) {
+            db.AddRecord(MakeRecord(i));
+        }
+        Report("AddRecord (one transaction per row)", n, watch.Seconds());
+    }
+    for (std::size_t batch_size : {100, 1000, 10000}) {
+        Database db(ResetDatabaseFile(context));
+        std::size_t i = 0;
+        Stopwatch watch;
+        std::size_t added = db.AddRecords(
+            [&](Record &record) {
+                if (i == context.rows) {
+                    return false;
+                }
+                record = MakeRecord(i++);
+                return true;
+            },
+            batch_size);
+        Report("AddRecords (batch " + std::to_string(batch_size) + ")", added,
+               watch.Seconds());
+    }
+    {
+        std::stringstream csv;
+        for (std::size_t i = 0; i < context.rows; i++) {
+            Record record = MakeRecord(i);
+            csv << record.first_name << ',' << record.last_name << ','
+                << record.email << ',' << record.telephone << '\n';
+        }
+        Database db(ResetDatabaseFile(context));
+        Stopwatch watch;
+        ImportResult result = ImportRecords(db, csv, ImportFormat::Csv);
+        Report("ImportRecords (CSV)", result.imported, watch.Seconds());
+    }
+}
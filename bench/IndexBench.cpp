@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <sqlite3.h>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+namespace {
+// The SQL of Database::GetRecords and Database::GetRecordByName
+const char *const kLookups[] = {
+    "SELECT first_name, last_name, email, telephone, ROWID FROM contacts"
+    " WHERE first_name_key = ?1"
+    " UNION SELECT first_name, last_name, email, telephone, ROWID"
+    " FROM contacts WHERE last_name_key = ?2"
+    " UNION SELECT first_name, last_name, email, telephone, ROWID"
+    " FROM contacts WHERE email_key = ?3"
+    " UNION SELECT first_name, last_name, email, telephone, ROWID"
+    " FROM contacts WHERE telephone_key = ?4"
+    " ORDER BY 5",
+    "SELECT first_name, last_name, email, telephone, ROWID FROM contacts"
+    " WHERE first_name_key = ? AND last_name_key = ?"};
+
+/**
+ * @brief Checks the EXPLAIN QUERY PLAN of every lookup on the database file
+ * of the context.
+ *
+ * @throws std::runtime_error If a step of a plan scans a table or index
+ * instead of searching it
+ */
+void CheckQueryPlans(const Context &context) {
+    sqlite3 *raw;
+    if (sqlite3_open_v2(context.db_path.c_str(), &raw, SQLITE_OPEN_READONLY,
+                        nullptr) != SQLITE_OK) {
+        sqlite3_close(raw);
+        throw std::runtime_error("Cannot open " + context.db_path);
+    }
+    std::string scans;
+    for (const char *sql : kLookups) {
+        const std::string explain = std::string("EXPLAIN QUERY PLAN ") + sql;
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(raw, explain.c_str(), -1, &stmt, nullptr) !=
+            SQLITE_OK) {
+            std::string error = sqlite3_errmsg(raw);
+            sqlite3_close(raw);
+            throw std::runtime_error(error);
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            // The columns are id, parent, notused and detail
+            std::string detail(
+                reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3)));
+            if (detail.rfind("SCAN", 0) == 0) {
+                scans += "\n  " + detail;
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(raw);
+    if (!scans.empty()) {
+        throw std::runtime_error("A lookup scans instead of using an index:" +
+                                 scans);
+    }
+}
+}  // namespace
+
+AB_BENCHMARK(indexed_lookups) {
+    Database db(ResetDatabaseFile(context));
+    LoadDataset(db, context.rows);
+    CheckQueryPlans(context);
+    const std::size_t n = context.iterations;
+    {
+        Stopwatch watch;
+        for (std::size_t j = 0; j < n; j++) {
+            Record record = MakeRecord(j * 7919 % context.rows);
+            db.GetRecordByName(record.first_name, record.last_name);
+        }
+        Report("GetRecordByName", n, watch.Seconds());
+    }
+    {
+        Stopwatch watch;
+        for (std::size_t j = 0; j < n; j++) {
+            Record record = MakeRecord(j * 7919 % context.rows);
+            // Only the email matches, the other fields miss
+            record.first_name = "nobody";
+            record.last_name = "nobody";
+            record.telephone = "-";
+            db.GetRecords(record);
+        }
+        Report("GetRecords (one field matches)", n, watch.Seconds());
+    }
+    {
+        Stopwatch watch;
+        std::size_t deletes = std::min(n, context.rows);
+        for (std::size_t j = 0; j < deletes; j++) {
+            Record record = MakeRecord(j);
+            db.DeleteRecord(record.first_name, record.last_name);
+        }
+        Report("DeleteRecord (first_name, last_name)", deletes,
+               watch.Seconds());
+    }
+}
@@ -0,0 +1,34 @@
+#include "Benchmark.hpp"
+#include "Database.hpp"
+#include "DatabaseException.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(metrics) {
+    // In memory, so that the cost of recording is not hidden by I/O
+    Database db("file:metrics?mode=memory&cache=shared");
+    LoadDataset(db, context.rows);
+    for (bool enabled : {false, true}) {
+        if (enabled) {
+            try {
+                db.EnableMetrics();
+            } catch (const DatabaseException &e) {
+                // Built without ADDRESS_BOOK_METRICS, nothing to compare
+                std::cout << e.what() << std::endl;
+                break;
+            }
+        }
+        const std::string suffix =
+            enabled ? " (metrics enabled)" : " (metrics disabled)";
+        Stopwatch watch;
+        for (std::size_t i = 0; i < context.iterations; i++) {
+            Record record = MakeRecord(i * 7919 % context.rows);
+            db.GetRecordByName(record.first_name, record.last_name);
+        }
+        Report("GetRecordByName" + suffix, context.iterations, watch.Seconds());
+        watch = Stopwatch();
+        std::size_t rows = db.Scan([](const RecordView &) { return true; });
+        Report("Scan" + suffix, rows, watch.Seconds());
+    }
+}
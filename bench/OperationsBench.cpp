@@ -0,0 +1,84 @@
+#include <algorithm>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+/**
+ * The core Database operations on datasets of 10^3 rows up to --rows,
+ * opened with the --preset options. Operations that commit once per call
+ * are capped at 1000 per size, since each of them syncs the file.
+ */
+AB_BENCHMARK(operations) {
+    for (std::size_t rows : DatasetSizes(context)) {
+        const std::string suffix = " (" + std::to_string(rows) + " rows)";
+        Database db(ResetDatabaseFile(context), context.Options());
+        {
+            Stopwatch watch;
+            LoadDataset(db, rows);
+            Report("AddRecords" + suffix, rows, watch.Seconds());
+        }
+        const std::size_t reads = context.iterations;
+        const std::size_t writes = std::min<std::size_t>(reads, 1000);
+        {
+            LatencyRecorder latencies(writes);
+            for (std::size_t i = 0; i < writes; i++) {
+                Record record = MakeRecord(rows + i);
+                latencies.Measure([&]() { db.AddRecord(record); });
+            }
+            Report("AddRecord" + suffix, latencies);
+        }
+        {
+            LatencyRecorder latencies(reads);
+            for (std::size_t i = 0; i < reads; i++) {
+                Record record = MakeRecord(i * 7919 % rows);
+                latencies.Measure([&]() {
+                    db.GetRecordByName(record.first_name, record.last_name);
+                });
+            }
+            Report("GetRecordByName" + suffix, latencies);
+        }
+        {
+            LatencyRecorder latencies(reads);
+            for (std::size_t i = 0; i < reads; i++) {
+                // Matches by email only
+                Record record = MakeRecord(i * 7919 % rows);
+                record.first_name = record.last_name = record.telephone = "-";
+                latencies.Measure([&]() { db.GetRecords(record); });
+            }
+            Report("GetRecords" + suffix, latencies);
+        }
+        {
+            const std::size_t scans = std::max<std::size_t>(
+                1, std::min<std::size_t>(reads, 1'000'000 / rows));
+            LatencyRecorder latencies(scans);
+            for (std::size_t i = 0; i < scans; i++) {
+                latencies.Measure([&]() { db.GetAllRecords(); });
+            }
+            Report("GetAllRecords" + suffix, latencies);
+        }
+        {
+            LatencyRecorder latencies(writes);
+            for (std::size_t i = 0; i < writes; i++) {
+                int rowid = static_cast<int>(i * 7919 % rows) + 1;
+                Record record = MakeRecord(rows + i);
+                latencies.Measure([&]() { db.UpdateRecord(rowid, record); });
+            }
+            Report("UpdateRecord" + suffix, latencies);
+        }
+        {
+            LatencyRecorder latencies(writes);
+            for (std::size_t i = 0; i < writes; i++) {
+                int rowid = static_cast<int>(i * 7919 % rows) + 1;
+                latencies.Measure([&]() { db.DeleteRecord(rowid); });
+            }
+            Report("DeleteRecord" + suffix, latencies);
+        }
+        {
+            LatencyRecorder latencies(1);
+            latencies.Measure([&]() { db.ClearRecords(); });
+            Report("ClearRecords" + suffix, latencies);
+        }
+    }
+}
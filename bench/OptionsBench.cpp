@@ -0,0 +1,43 @@
+#include <algorithm>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(options_presets) {
+    for (const char *preset : {"default", "durable", "fast"}) {
+        Database db(ResetDatabaseFile(context),
+                    DatabaseOptions::FromPreset(preset));
+        const std::string name(preset);
+        {
+            // One commit per row, bounded since it syncs every row
+            std::size_t n = std::min<std::size_t>(context.iterations, 500);
+            Stopwatch watch;
+            for (std::size_t i = 0; i < n; i++) {
+                db.AddRecord(MakeRecord(context.rows + i));
+            }
+            Report(name + ": AddRecord", n, watch.Seconds());
+        }
+        {
+            Stopwatch watch;
+            LoadDataset(db, context.rows);
+            Report(name + ": AddRecords", context.rows, watch.Seconds());
+        }
+        {
+            Stopwatch watch;
+            for (std::size_t j = 0; j < context.iterations; j++) {
+                Record record = MakeRecord(j * 7919 % context.rows);
+                db.GetRecordByName(record.first_name, record.last_name);
+            }
+            Report(name + ": GetRecordByName", context.iterations,
+                   watch.Seconds());
+        }
+        {
+            Stopwatch watch;
+            std::size_t rows =
+                db.Scan([](const RecordView &) { return true; });
+            Report(name + ": Scan (rows)", rows, watch.Seconds());
+        }
+    }
+}
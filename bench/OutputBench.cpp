@@ -0,0 +1,44 @@
+#include <cstdio>
+#include <fstream>
+#include <utility>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+#include "RecordWriter.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(output) {
+    const std::string output_path = context.db_path + ".out";
+    Database db(ResetDatabaseFile(context), context.Options());
+    LoadDataset(db, context.rows);
+    {
+        // The list command used to flush the stream after every record
+        std::ofstream os(output_path, std::ios::binary);
+        Stopwatch watch;
+        std::size_t count = db.Scan([&](const RecordView &record) {
+            os << record << std::flush;
+            os << std::string(30, '-') << '\n';
+            return true;
+        });
+        Report("Scan and flush every record", count, watch.Seconds());
+    }
+    const std::pair<const char *, OutputFormat> formats[] = {
+        {"text", OutputFormat::Text},
+        {"table", OutputFormat::Table},
+        {"csv", OutputFormat::Csv},
+        {"jsonl", OutputFormat::JsonLines}};
+    for (const auto &format : formats) {
+        std::ofstream os(output_path, std::ios::binary);
+        Stopwatch watch;
+        RecordWriter writer(os, format.second);
+        db.Scan([&](const RecordView &record) {
+            writer.Write(record);
+            return true;
+        });
+        writer.Flush();
+        Report(std::string("Scan and RecordWriter ") + format.first,
+               writer.Count(), watch.Seconds());
+    }
+    std::remove(output_path.c_str());
+}
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Benchmark.hpp"
+#include "DatabasePool.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(pool_readers) {
+    std::string uri = ResetDatabaseFile(context);
+    const std::size_t max_threads =
+        std::max(2u, std::thread::hardware_concurrency());
+    DatabaseOptions options;
+    options.busy_timeout_ms = 1000;
+    DatabasePool pool(uri, max_threads, options);
+    pool.Write([&](Database &db) {
+        LoadDataset(db, context.rows);
+    });
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        // A writer keeps updating rows while the readers run
+        std::atomic<bool> done(false);
+        std::size_t writes = 0;
+        std::thread writer([&]() {
+            while (!done) {
+                pool.Write([&](Database &db) {
+                    return db.UpdateRecord(
+                        static_cast<int>(writes % context.rows) + 1,
+                        MakeRecord(writes % context.rows));
+                });
+                writes++;
+            }
+        });
+        std::vector<std::thread> readers;
+        Stopwatch watch;
+        for (std::size_t t = 0; t < threads; t++) {
+            readers.emplace_back([&, t]() {
+                for (std::size_t j = t; j < context.iterations; j += threads) {
+                    Record record = MakeRecord(j * 7919 % context.rows);
+                    pool.Read([&](const Database &db) {
+                        return db.GetRecordByName(record.first_name,
+                                                  record.last_name);
+                    });
+                }
+            });
+        }
+        for (auto &reader : readers) {
+            reader.join();
+        }
+        double seconds = watch.Seconds();
+        done = true;
+        writer.join();
+        Report("GetRecordByName, " + std::to_string(threads) +
+                   " reader threads",
+               context.iterations, seconds);
+        Report("  UpdateRecord, concurrent writer", writes, seconds);
+    }
+}
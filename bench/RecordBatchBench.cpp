@@ -0,0 +1,56 @@
+#include <algorithm>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+namespace {
+/**
+ * @brief Estimates the memory held by a vector of records: the vector and
+ * every string that does not fit in its small-string buffer
+ */
+std::size_t MemoryBytes(const std::vector<Record> &records) {
+    const std::size_t inline_capacity = std::string().capacity();
+    std::size_t bytes =
+        sizeof(records) + records.capacity() * sizeof(Record);
+    for (const auto &record : records) {
+        for (const std::string *field : {&record.first_name, &record.last_name,
+                                         &record.email, &record.telephone}) {
+            if (field->capacity() > inline_capacity) {
+                bytes += field->capacity() + 1;
+            }
+        }
+    }
+    return bytes;
+}
+}  // namespace
+
+AB_BENCHMARK(record_batch) {
+    Database db(ResetDatabaseFile(context), context.Options());
+    LoadDataset(db, context.rows);
+    const std::size_t scans = std::max<std::size_t>(
+        1, std::min<std::size_t>(context.iterations, 10'000'000 / context.rows));
+    std::size_t vector_bytes = 0;
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < scans; i++) {
+            auto records = db.GetAllRecords();
+            vector_bytes = MemoryBytes(records);
+        }
+        Report("GetAllRecords, std::vector<Record> (rows)",
+               scans * context.rows, watch.Seconds());
+    }
+    RecordBatch batch;
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < scans; i++) {
+            db.GetAllRecords(batch);
+        }
+        Report("GetAllRecords, reused RecordBatch (rows)",
+               scans * context.rows, watch.Seconds());
+    }
+    std::cout << "bytes per row: std::vector<Record> "
+              << vector_bytes / context.rows << ", RecordBatch "
+              << batch.MemoryBytes() / context.rows << std::endl;
+}
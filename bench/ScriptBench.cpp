@@ -0,0 +1,32 @@
+#include <sstream>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+#include "ScriptRunner.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(script) {
+    // Adds, then updates and deletes of half of the added records
+    std::string script;
+    for (std::size_t i = 0; i < context.iterations; i++) {
+        Record record = MakeRecord(i);
+        script += "add " + record.first_name + ' ' + record.last_name + ' ' +
+                  record.email + ' ' + record.telephone + '\n';
+    }
+    for (std::size_t i = 1; i <= context.iterations / 2; i++) {
+        script += i % 2 == 0 ? "delete " + std::to_string(i) + '\n'
+                             : "update " + std::to_string(i) +
+                                   " Updated Name updated@example.org 555\n";
+    }
+    // One transaction per command is what the interactive menu does
+    for (std::size_t batch_size : {std::size_t(1), Database::kDefaultBatchSize}) {
+        Database db(ResetDatabaseFile(context), context.Options());
+        std::istringstream input(script);
+        std::ostringstream output;
+        ScriptResult result = RunScript(db, input, output, batch_size);
+        Report("RunScript, " + std::to_string(batch_size) +
+                   " commands per transaction",
+               result.commands, result.seconds);
+    }
+}
@@ -0,0 +1,21 @@
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(prefix_search) {
+    // Prefixes of the synthetic first names, last names and email domains
+    const char *const queries[] = {"pet", "last12", "outl", "vivian user1",
+                                   "jo", "2000"};
+    for (std::size_t rows : DatasetSizes(context)) {
+        Database db(ResetDatabaseFile(context));
+        LoadDataset(db, rows);
+        Stopwatch watch;
+        for (std::size_t j = 0; j < context.iterations; j++) {
+            db.Search(queries[j % 6], 20);
+        }
+        Report("Search, limit 20 (" + std::to_string(rows) + " rows)",
+               context.iterations, watch.Seconds());
+    }
+}
@@ -0,0 +1,46 @@
+#include <cstdio>
+#include "Benchmark.hpp"
+#include "ShardedDatabase.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+namespace {
+void RemoveShards(const Context &context, std::size_t shards) {
+    for (std::size_t i = 0; i < shards; i++) {
+        for (const char *suffix : {"", "-journal", "-wal", "-shm"}) {
+            std::remove(
+                (context.db_path + "-" + std::to_string(i) + suffix).c_str());
+        }
+    }
+}
+}  // namespace
+
+AB_BENCHMARK(shards) {
+    std::vector<Record> records;
+    for (std::size_t i = 0; i < context.rows; i++) {
+        records.push_back(MakeRecord(i));
+    }
+    for (std::size_t shards : {1, 2, 4, 8}) {
+        RemoveShards(context, shards);
+        {
+            ShardedDatabase db("file:" + context.db_path + "-{shard}", shards,
+                               context.Options());
+            const std::string suffix = ", " + std::to_string(shards) + " shards";
+            Stopwatch watch;
+            db.AddRecords(records);
+            Report("AddRecords" + suffix, records.size(), watch.Seconds());
+            watch = Stopwatch();
+            std::size_t rows = db.GetAllRecords().size();
+            Report("GetAllRecords" + suffix, rows, watch.Seconds());
+            watch = Stopwatch();
+            for (std::size_t i = 0; i < context.iterations; i++) {
+                const Record &record = records[i * 7919 % records.size()];
+                db.GetRecordByName(record.first_name, record.last_name);
+            }
+            Report("GetRecordByName" + suffix, context.iterations,
+                   watch.Seconds());
+        }
+        RemoveShards(context, shards);
+    }
+}
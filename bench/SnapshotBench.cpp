@@ -0,0 +1,41 @@
+#include <cstdio>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+#include "Snapshot.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+AB_BENCHMARK(snapshot) {
+    const std::string snapshot_path = context.db_path + ".snapshot";
+    const std::string backup_path = context.db_path + ".backup";
+    {
+        Database db(ResetDatabaseFile(context), context.Options());
+        LoadDataset(db, context.rows);
+        Stopwatch watch;
+        SaveSnapshot(db, snapshot_path);
+        Report("SaveSnapshot", context.rows, watch.Seconds());
+        std::remove(backup_path.c_str());
+        watch = Stopwatch();
+        db.Backup("file:" + backup_path);
+        Report("Backup", context.rows, watch.Seconds());
+    }
+    {
+        // Opening checks the checksum and indexes every record
+        Stopwatch watch;
+        SnapshotView view(snapshot_path);
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < view.Size(); i++) {
+            bytes += view[i].email.size();
+        }
+        Report("SnapshotView open and scan", view.Size(), watch.Seconds());
+    }
+    {
+        Database db(ResetDatabaseFile(context), context.Options());
+        Stopwatch watch;
+        SnapshotResult result = LoadSnapshot(db, snapshot_path);
+        Report("LoadSnapshot", result.records, watch.Seconds());
+    }
+    std::remove(snapshot_path.c_str());
+    std::remove(backup_path.c_str());
+}
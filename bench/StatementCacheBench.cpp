@@ -0,0 +1,91 @@
+#include <sqlite3.h>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+namespace {
+// An in-memory database shared by both connections, so that the
+// measurement is not dominated by fsync
+const char *const kSharedUri = "file:statement_cache?mode=memory&cache=shared";
+
+/**
+ * @brief Looks up a record by name the way Database did before statements
+ * were cached: prepare, bind, step and finalize on every call.
+ */
+int UncachedGetRecordByName(sqlite3 *db, const Record &record) {
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db,
+                       "SELECT first_name, last_name, email, telephone, ROWID"
+                       " FROM contacts WHERE first_name = ? AND last_name = ?",
+                       -1, &stmt, nullptr);
+    sqlite3_bind_text(stmt, 1, record.first_name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, record.last_name.c_str(), -1, SQLITE_STATIC);
+    int id = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        id = sqlite3_column_int(stmt, 4);
+    }
+    sqlite3_finalize(stmt);
+    return id;
+}
+
+int UncachedUpdateRecord(sqlite3 *db, int rowid, const Record &record) {
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db,
+                       "UPDATE contacts SET first_name = ?, last_name = ?,"
+                       " email = ?, telephone = ? WHERE ROWID = ?",
+                       -1, &stmt, nullptr);
+    sqlite3_bind_text(stmt, 1, record.first_name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, record.last_name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, record.email.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, record.telephone.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, rowid);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return sqlite3_changes(db);
+}
+}  // namespace
+
+AB_BENCHMARK(statement_cache) {
+    Database db(kSharedUri);
+    sqlite3 *raw;
+    sqlite3_open_v2(kSharedUri, &raw,
+                    SQLITE_OPEN_READWRITE | SQLITE_OPEN_URI, nullptr);
+    for (std::size_t i = 0; i < context.rows; i++) {
+        db.AddRecord(MakeRecord(i));
+    }
+    const std::size_t n = context.iterations;
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < n; i++) {
+            UncachedGetRecordByName(raw, MakeRecord(i % context.rows));
+        }
+        Report("GetRecordByName (prepare per call)", n, watch.Seconds());
+    }
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < n; i++) {
+            Record record = MakeRecord(i % context.rows);
+            db.GetRecordByName(record.first_name, record.last_name);
+        }
+        Report("GetRecordByName (cached)", n, watch.Seconds());
+    }
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < n; i++) {
+            UncachedUpdateRecord(raw, static_cast<int>(i % context.rows) + 1,
+                                 MakeRecord(i % context.rows));
+        }
+        Report("UpdateRecord (prepare per call)", n, watch.Seconds());
+    }
+    {
+        Stopwatch watch;
+        for (std::size_t i = 0; i < n; i++) {
+            db.UpdateRecord(static_cast<int>(i % context.rows) + 1,
+                            MakeRecord(i % context.rows));
+        }
+        Report("UpdateRecord (cached)", n, watch.Seconds());
+    }
+    sqlite3_close_v2(raw);
+}
@@ -0,0 +1,42 @@
+#include <fstream>
+#include "Benchmark.hpp"
+#include "Database.hpp"
+
+using namespace AddressBook;
+using namespace AddressBook::Bench;
+
+namespace {
+std::size_t FileBytes(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<std::size_t>(file.tellg()) : 0;
+}
+}  // namespace
+
+AB_BENCHMARK(storage) {
+    for (bool compressed : {false, true}) {
+        const std::string name = compressed ? " (compressed)" : " (plain)";
+        const std::string uri = ResetDatabaseFile(context);
+        DatabaseOptions options = context.Options();
+        options.compressed = compressed;
+        {
+            Database db(uri, options);
+            Stopwatch watch;
+            LoadDataset(db, context.rows);
+            Report("LoadDataset" + name, context.rows, watch.Seconds());
+        }
+        // Closing the last connection checkpoints the WAL into the file
+        ReportBytes("File" + name, FileBytes(context.db_path));
+        Database db(uri, options);
+        for (const char *pass : {" cold", " warm"}) {
+            std::size_t bytes = 0;
+            Stopwatch watch;
+            std::size_t count = db.Scan([&](const RecordView &record) {
+                bytes += record.email.size() + record.telephone.size();
+                return true;
+            });
+            Report("Scan" + name + pass, count, watch.Seconds());
+        }
+        ReportBytes("Page cache after Scan" + name,
+                    db.GetMetrics().sqlite.cache_used_bytes);
+    }
+}
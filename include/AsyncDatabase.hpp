@@ -0,0 +1,144 @@
+#ifndef ASYNC_DATABASE_HPP
+#define ASYNC_DATABASE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Database.hpp"
+#include "DatabaseOptions.hpp"
+#include "Record.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Settings of the write queue of an AsyncDatabase
+ */
+struct AsyncOptions {
+    // Commit the writes queued at the same time in one transaction
+    bool group_commit = true;
+    // The maximum number of writes committed together
+    std::size_t max_group_size = 1000;
+};
+
+/**
+ * @brief Runs Database operations on a dedicated thread that owns the
+ * connection, and returns their results as futures, so callers never
+ * block on SQLite.
+ * With group commit, the writes waiting in the queue when the worker gets
+ * to them run in one transaction, each in its own savepoint: a failing
+ * write only rolls back itself. Write futures become ready once the
+ * transaction is committed. The class is thread-safe.
+ */
+class AsyncDatabase {
+   public:
+    AsyncDatabase(const std::string &uri,
+                  const DatabaseOptions &options = DatabaseOptions(),
+                  const AsyncOptions &async_options = AsyncOptions());
+    AsyncDatabase(const AsyncDatabase &) = delete;
+    AsyncDatabase &operator=(const AsyncDatabase &) = delete;
+    ~AsyncDatabase();
+
+    /**
+     * @brief Queues a read-only operation.
+     *
+     * @param operation Called on the worker thread with a `const Database &`
+     * @return std::future of the result of `operation`
+     */
+    template <typename Operation>
+    auto Read(Operation operation) {
+        return this->Submit<const Database &>(std::move(operation), false);
+    }
+
+    /**
+     * @brief Queues an operation that may change the database.
+     *
+     * @param operation Called on the worker thread with a `Database &`
+     * @return std::future of the result of `operation`, ready once the
+     * change is committed
+     */
+    template <typename Operation>
+    auto Write(Operation operation) {
+        return this->Submit<Database &>(std::move(operation), true);
+    }
+
+    std::future<void> AddRecord(Record record);
+    std::future<int> UpdateRecord(int rowid, Record record);
+    std::future<int> DeleteRecord(int rowid);
+    std::future<Record> GetRecordByName(std::string first_name,
+                                        std::string last_name);
+    std::future<std::vector<Record>> GetAllRecords();
+
+   private:
+    /**
+     * @brief A queued operation. Run executes it, Complete hands its result
+     * or error to the future.
+     */
+    struct Task {
+        explicit Task(bool write) : write(write) {}
+        virtual ~Task() = default;
+        virtual void Run(Database &db) = 0;
+        virtual void Complete() = 0;
+        bool write;
+        std::exception_ptr error;
+    };
+
+    template <typename Result, typename DatabaseRef, typename Operation>
+    struct TypedTask : Task {
+        TypedTask(Operation operation, bool write)
+            : Task(write), operation(std::move(operation)) {}
+        void Run(Database &db) override {
+            if constexpr (std::is_void_v<Result>) {
+                this->operation(static_cast<DatabaseRef>(db));
+            } else {
+                this->result.emplace(
+                    this->operation(static_cast<DatabaseRef>(db)));
+            }
+        }
+        void Complete() override {
+            if (this->error) {
+                this->promise.set_exception(this->error);
+            } else if constexpr (std::is_void_v<Result>) {
+                this->promise.set_value();
+            } else {
+                this->promise.set_value(std::move(*this->result));
+            }
+        }
+        Operation operation;
+        std::promise<Result> promise;
+        std::optional<std::conditional_t<std::is_void_v<Result>, bool, Result>>
+            result;
+    };
+
+    template <typename DatabaseRef, typename Operation>
+    auto Submit(Operation operation, bool write) {
+        using Result = std::invoke_result_t<Operation &, DatabaseRef>;
+        auto task = std::make_unique<TypedTask<Result, DatabaseRef, Operation>>(
+            std::move(operation), write);
+        auto future = task->promise.get_future();
+        this->Enqueue(std::move(task));
+        return future;
+    }
+
+    void Enqueue(std::unique_ptr<Task> task);
+    void Work(const std::string &uri, const DatabaseOptions &options,
+              std::promise<void> opened);
+    void RunGroup(Database &db, std::vector<std::unique_ptr<Task>> &group);
+    AsyncOptions async_options;
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::deque<std::unique_ptr<Task>> queue;
+    bool stopping = false;
+    std::thread worker;
+};
+}  // namespace AddressBook
+
+#endif  // ASYNC_DATABASE_HPP
@@ -1,30 +1,215 @@
+#ifndef DATABASE_HPP
+#define DATABASE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <sqlite3.h>
+#include "DatabaseOptions.hpp"
+#include "Metrics.hpp"
 #include "Record.hpp"
+#include "RecordBatch.hpp"
+#include "RecordCache.hpp"
 
 namespace AddressBook {
+// The order of the records in a page
+enum class PageOrder {
+    Rowid,  // By rowid, i.e. roughly in insertion order
+    Name    // By last name, then first name, then rowid
+};
+
+// The kind of change recorded in the change feed
+enum class ChangeType {
+    Insert,
+    Update,
+    Delete,
+    Clear  // All records were removed
+};
+
+/**
+ * @brief An entry of the change feed
+ */
+struct Change {
+    std::int64_t sequence = 0;  // Increases with every change
+    ChangeType type = ChangeType::Insert;
+    // The record after the change. Only the id is set for a Delete, and
+    // nothing for a Clear.
+    Record record;
+};
+
 class Database {
    public:
-    Database(const std::string &uri);
-    void AddRecord(const Record &record);
+    /**
+     * @brief A transaction on a Database, rolled back on destruction unless
+     * committed. Transactions nest: the outermost one is a transaction, the
+     * inner ones are savepoints within it. Every Database method called
+     * while a transaction is open takes part in it. Transactions must be
+     * committed or rolled back innermost first.
+     */
+    class Transaction {
+       public:
+        explicit Transaction(Database &db);
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+        ~Transaction();
+        void Commit();
+        void Rollback();
+        bool Active() const;
+
+       private:
+        void CheckInnermost() const;
+        Database &db;
+        int depth;  // 1 for the outermost transaction
+        bool open = true;
+    };
+
+    // Called once per row of a scan, returns false to stop the scan
+    using RecordVisitor = std::function<bool(const RecordView &)>;
+    // Version of the schema created by CreateSchema, kept in user_version
+    static constexpr int kSchemaVersion = 5;
+    // Rows per transaction used by the bulk operations
+    static constexpr std::size_t kDefaultBatchSize = 1000;
+    Database(const std::string &uri,
+             const DatabaseOptions &options = DatabaseOptions());
+    Database(const Database &) = delete;
+    Database &operator=(const Database &) = delete;
+    int AddRecord(const Record &record);
+    std::size_t AddRecords(const std::vector<Record> &records,
+                           std::size_t batch_size = kDefaultBatchSize);
+    std::size_t AddRecords(const std::function<bool(Record &)> &next,
+                           std::size_t batch_size = kDefaultBatchSize);
     std::vector<Record> GetRecords(const Record &record) const;
+    void GetRecords(const Record &record, RecordBatch &batch) const;
     Record GetRecordByName(const std::string &first_name, const std::string &last_name) const;
     std::vector<Record> GetAllRecords() const;
+    void GetAllRecords(RecordBatch &batch) const;
+    std::vector<Record> GetRecordsPage(int after_rowid, int limit,
+                                       PageOrder order = PageOrder::Rowid) const;
+    std::vector<Record> Search(const std::string &query, int limit) const;
+    bool HasFullTextSearch() const;
+    std::size_t Scan(const RecordVisitor &visitor) const;
+    std::size_t Scan(const Record &record, const RecordVisitor &visitor) const;
     int DeleteRecord(const std::string &first_name, const std::string &last_name);
     int DeleteRecord(const Record &record);
     int DeleteRecord(int rowid);
     int UpdateRecord(int rowid, const Record& record) const;
+    std::vector<int> UpdateRecords(const std::vector<std::pair<int, Record>> &updates,
+                                   std::size_t batch_size = kDefaultBatchSize);
+    std::vector<int> DeleteRecords(const std::vector<int> &rowids,
+                                   std::size_t batch_size = kDefaultBatchSize);
+    int TransactionDepth() const;
+
+    /**
+     * @brief Runs `operation` in a transaction, committed if it returns and
+     * rolled back if it throws.
+     *
+     * @param operation Called with this database
+     * @return The result of `operation`
+     */
+    template <typename Operation>
+    auto InTransaction(Operation &&operation) {
+        Transaction transaction(*this);
+        if constexpr (std::is_void_v<decltype(operation(*this))>) {
+            operation(*this);
+            transaction.Commit();
+        } else {
+            auto result = operation(*this);
+            transaction.Commit();
+            return result;
+        }
+    }
     void ClearRecords();
+    std::vector<Change> ChangesSince(std::int64_t sequence, int limit) const;
+    std::int64_t LatestChange() const;
+    int CompactChanges(std::int64_t through_sequence);
+    void EnableCache(std::size_t byte_budget);
+    void DisableCache();
+    CacheStats GetCacheStats() const;
+    void EnableMetrics();
+    void DisableMetrics();
+    MetricsReport GetMetrics() const;
+    DatabaseOptions GetEffectiveOptions() const;
+    void Backup(const std::string &uri, int pages_per_step = 256) const;
     ~Database();
 
    private:
-    void CreateTableIfNotExists();
+    // Keys of the statements kept prepared for the life of the connection
+    enum class Statement {
+        AddRecord,
+        GetRecords,
+        GetRecordByName,
+        GetAllRecords,
+        PageByRowid,
+        FirstPageByName,
+        PageByName,
+        Search,
+        DeleteByName,
+        DeleteByDetails,
+        DeleteById,
+        UpdateRecord,
+        ChangesSince,
+        OldestChange,
+        LatestChange,
+        CompactChanges,
+        FindDomain,
+        AddDomain,
+        GetDomain,
+        Count
+    };
+    // The email and telephone of a row of a compressed database, unpacked
+    struct UnpackedFields {
+        std::string email;
+        std::string telephone;
+    };
+    void ApplyOptions(const DatabaseOptions &options);
+    void RegisterFunctions();
+    bool HasTable(const char *name) const;
+    void CreateSchema();
+    void MigrateSchema(int from_version);
+    void CreateFullTextSearch();
+    void CreateFullTextTriggers();
+    int GetSchemaVersion() const;
+    std::string QueryPragma(const char *pragma) const;
+    void Execute(const char *sql);
+    std::vector<int> RunInBatches(const std::function<bool(int &)> &step,
+                                  std::size_t batch_size);
+    sqlite3_stmt *PrepareCached(Statement key, const char *sql) const;
+    void FinalizeStatements();
+    int Step(Statement key) const;
+    int StepAndCountChanges(Statement key) const;
+    std::int64_t FindDomain(std::string_view domain, bool add) const;
+    const std::string &DomainName(std::int64_t id) const;
+    void UnpackEmailField(std::string_view packed, std::string &email) const;
     Record GetRecordFromRow(sqlite3_stmt *stmt) const;
-    static int GetAllRecordsCallback(void *arg, int colc, char **colv, char **col_name);
-    static sqlite3_stmt *BindStatement(const Record &record, sqlite3_stmt *stmt);
+    RecordView GetViewFromRow(sqlite3_stmt *stmt, UnpackedFields &unpacked) const;
+    std::size_t ScanStatement(Statement key, const RecordVisitor &visitor) const;
+    sqlite3_stmt *BindStatement(const Record &record, sqlite3_stmt *stmt,
+                                bool add_domains = true) const;
+    static sqlite3_stmt *BindKeys(const Record &record, sqlite3_stmt *stmt, int first_index);
     static sqlite3_stmt *BindStatementText(sqlite3_stmt *stmt, std::initializer_list<std::string> params);
     sqlite3* ppdb;  // Sqlite db handler
+    // Prepared statements indexed by Statement, prepared lazily
+    mutable std::array<sqlite3_stmt *, static_cast<std::size_t>(Statement::Count)>
+        statements{};
+    // Read-through cache of GetRecordByName, null when disabled
+    mutable std::unique_ptr<RecordCache> cache;
+    // Metrics of the cached statements, null when disabled
+    mutable std::unique_ptr<MetricsRecorder> metrics;
+    // Number of open Transaction objects
+    int transaction_depth = 0;
+    // Whether emails and telephones are stored packed, see Packing.hpp
+    bool compressed = false;
+    // Rows of contacts_email_domains read or added so far, both ways
+    mutable std::unordered_map<std::string, std::int64_t> domain_ids;
+    mutable std::unordered_map<std::int64_t, std::string> domain_names;
     const std::string table_def =
         "CREATE TABLE IF NOT EXISTS contacts ("
         "    first_name TEXT,"
@@ -34,3 +219,5 @@ class Database {
         ")";
 };
 }  // namespace AddressBook
+
+#endif  // DATABASE_HPP
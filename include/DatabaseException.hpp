@@ -4,9 +4,11 @@
 namespace AddressBook {
 class DatabaseException : std::exception {
     public:
-    DatabaseException(const std::string msg);
+    DatabaseException(const std::string msg, int code = 0);
     const char* what() const noexcept override;
+    int code() const noexcept;
     private:
     std::string msg;
+    int error_code;  // SQLite extended result code, 0 if not from SQLite
 };
-}  // namespace AddressBook
\ No newline at end of file
+}  // namespace AddressBook
@@ -0,0 +1,43 @@
+#ifndef DATABASE_OPTIONS_HPP
+#define DATABASE_OPTIONS_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+
+namespace AddressBook {
+/**
+ * @brief Settings applied when a Database opens its connection.
+ * Empty strings and empty optionals keep SQLite's current setting.
+ */
+struct DatabaseOptions {
+    // Open the connection read-only. The schema is then neither created
+    // nor migrated, so the database must already exist.
+    bool read_only = false;
+    // Milliseconds to wait for a lock held by another connection before
+    // failing with SQLITE_BUSY, 0 to fail at once
+    int busy_timeout_ms = 0;
+    // PRAGMA journal_mode: delete, truncate, persist, memory, wal or off
+    std::string journal_mode;
+    // PRAGMA synchronous: off, normal, full or extra
+    std::string synchronous;
+    // PRAGMA cache_size: pages if positive, KiB if negative
+    std::optional<int> cache_size;
+    // PRAGMA mmap_size: bytes of the file accessed through mmap, 0 disables
+    std::optional<std::int64_t> mmap_size;
+    // PRAGMA temp_store: default, file or memory
+    std::string temp_store;
+    // PRAGMA page_size in bytes. Only takes effect on a new database.
+    std::optional<int> page_size;
+    // Store emails with a dictionary of their domains and telephones packed
+    // in binary, to shrink the file. Only takes effect when the database
+    // file is created.
+    bool compressed = false;
+
+    static DatabaseOptions FromPreset(const std::string &preset);
+};
+std::ostream &operator<<(std::ostream &os, const DatabaseOptions &options);
+}  // namespace AddressBook
+
+#endif  // DATABASE_OPTIONS_HPP
@@ -0,0 +1,132 @@
+#ifndef DATABASE_POOL_HPP
+#define DATABASE_POOL_HPP
+
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Database.hpp"
+#include "DatabaseException.hpp"
+#include "DatabaseOptions.hpp"
+
+namespace AddressBook {
+/**
+ * @brief How DatabasePool::Read and DatabasePool::Write retry an operation
+ * that failed because the database was busy or locked
+ */
+struct RetryPolicy {
+    int max_attempts = 5;
+    std::chrono::milliseconds initial_backoff{5};
+    double backoff_multiplier = 2.0;
+};
+
+/**
+ * @brief A fixed set of connections to one database file in WAL mode: one
+ * writer and `readers` read-only connections, so that reads on different
+ * threads run in parallel with each other and with the writer.
+ * The pool is thread-safe; each connection is only used by the thread
+ * holding its lease. Read connections have no record cache, since the
+ * writer's changes would not invalidate it.
+ */
+class DatabasePool {
+   public:
+    /**
+     * @brief Exclusive use of one connection, given back to the pool when
+     * the lease is destroyed
+     */
+    class Lease {
+       public:
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease();
+        Database &operator*() const { return *this->db; }
+        Database *operator->() const { return this->db; }
+
+       private:
+        friend class DatabasePool;
+        Lease(DatabasePool *pool, Database *db);
+        void Release();
+        DatabasePool *pool;
+        Database *db;
+    };
+
+    DatabasePool(const std::string &uri, std::size_t readers,
+                 const DatabaseOptions &options = DatabaseOptions(),
+                 const RetryPolicy &retry = RetryPolicy());
+    DatabasePool(const DatabasePool &) = delete;
+    DatabasePool &operator=(const DatabasePool &) = delete;
+    Lease AcquireReader();
+    Lease AcquireWriter();
+    std::size_t ReaderCount() const;
+
+    /**
+     * @brief Runs `operation` on a read connection, retrying it with
+     * backoff while the database is busy or locked.
+     *
+     * @param operation Called with a `const Database &`
+     * @return The result of `operation`
+     */
+    template <typename Operation>
+    auto Read(Operation &&operation) {
+        return this->WithRetry([&]() {
+            Lease lease = this->AcquireReader();
+            return operation(static_cast<const Database &>(*lease));
+        });
+    }
+
+    /**
+     * @brief Runs `operation` in one transaction on the write connection,
+     * retrying it with backoff while the database is busy or locked. A
+     * busy attempt is rolled back as a whole before the retry, so
+     * operations committing in batches, such as AddRecords, never replay
+     * a batch that was already committed.
+     *
+     * @param operation Called with a `Database &`
+     * @return The result of `operation`
+     */
+    template <typename Operation>
+    auto Write(Operation &&operation) {
+        return this->WithRetry([&]() {
+            Lease lease = this->AcquireWriter();
+            return lease->InTransaction(operation);
+        });
+    }
+
+   private:
+    static bool IsBusy(const DatabaseException &e);
+    template <typename Operation>
+    auto WithRetry(Operation &&operation) {
+        auto backoff = this->retry.initial_backoff;
+        for (int attempt = 1;; attempt++) {
+            try {
+                return operation();
+            } catch (const DatabaseException &e) {
+                if (!IsBusy(e) || attempt >= this->retry.max_attempts) {
+                    throw;
+                }
+            }
+            std::this_thread::sleep_for(backoff);
+            backoff = std::chrono::duration_cast<std::chrono::milliseconds>(
+                backoff * this->retry.backoff_multiplier);
+        }
+    }
+    void Return(Database *db);
+    RetryPolicy retry;
+    std::unique_ptr<Database> writer;
+    std::vector<std::unique_ptr<Database>> readers;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool writer_idle = true;
+    std::vector<Database *> idle_readers;
+};
+}  // namespace AddressBook
+
+#endif  // DATABASE_POOL_HPP
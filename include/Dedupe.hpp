@@ -0,0 +1,42 @@
+#ifndef DEDUPE_HPP
+#define DEDUPE_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "Database.hpp"
+#include "Record.hpp"
+#include "RecordBatch.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Settings of FindDuplicates
+ */
+struct DedupeOptions {
+    // The minimum score of a reported pair, from 0 to 1
+    double threshold = 0.85;
+    // The number of following records in its block a record is compared to
+    std::size_t window = 16;
+    // The number of scoring threads, 0 for one per core
+    std::size_t threads = 0;
+};
+
+/**
+ * @brief Two records that likely describe the same contact
+ */
+struct DuplicatePair {
+    Record first;
+    Record second;
+    double score = 0;
+};
+
+std::size_t EditDistance(std::string_view a, std::string_view b);
+double Similarity(std::string_view a, std::string_view b);
+double MatchScore(const RecordView &a, const RecordView &b);
+std::vector<DuplicatePair> FindDuplicates(
+    const RecordBatch &records, const DedupeOptions &options = DedupeOptions());
+std::vector<DuplicatePair> FindDuplicates(
+    const Database &db, const DedupeOptions &options = DedupeOptions());
+}  // namespace AddressBook
+
+#endif  // DEDUPE_HPP
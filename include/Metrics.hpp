@@ -0,0 +1,94 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace AddressBook {
+/**
+ * @brief A histogram of latencies in nanoseconds. Buckets split every
+ * power of two in four, so percentiles are exact to within 25%.
+ */
+class LatencyHistogram {
+   public:
+    void Add(std::uint64_t nanoseconds);
+    std::uint64_t Count() const;
+    std::uint64_t TotalNanoseconds() const;
+    std::uint64_t MaxNanoseconds() const;
+    std::uint64_t Percentile(double percent) const;
+
+   private:
+    static constexpr std::size_t kBuckets = 4 * 64;
+    std::array<std::uint64_t, kBuckets> buckets{};
+    std::uint64_t count = 0;
+    std::uint64_t total = 0;
+    std::uint64_t max = 0;
+};
+
+/**
+ * @brief The counters of one cached statement
+ */
+struct StatementMetrics {
+    std::uint64_t prepares = 0;
+    std::uint64_t executions = 0;
+    std::uint64_t rows = 0;   // Returned by queries
+    std::uint64_t bytes = 0;  // Of the fields of the returned rows
+    LatencyHistogram prepare;
+    // From the statement being handed out to its first step
+    LatencyHistogram bind;
+    // Of every sqlite3_step, i.e. per row
+    LatencyHistogram step;
+};
+
+/**
+ * @brief The counters SQLite keeps for a connection, see sqlite3_db_status
+ */
+struct SqliteStatus {
+    int cache_hits = 0;
+    int cache_misses = 0;
+    int cache_writes = 0;
+    int cache_used_bytes = 0;
+    int schema_used_bytes = 0;
+    int statement_used_bytes = 0;
+};
+
+/**
+ * @brief A copy of the metrics of a connection
+ */
+struct MetricsReport {
+    // Statements that were prepared at least once, by name
+    std::vector<std::pair<std::string, StatementMetrics>> statements;
+    SqliteStatus sqlite;
+    std::string ToJson() const;
+};
+std::ostream &operator<<(std::ostream &os, const MetricsReport &report);
+
+/**
+ * @brief Records the metrics of the cached statements of a connection,
+ * indexed by statement.
+ */
+class MetricsRecorder {
+   public:
+    using Clock = std::chrono::steady_clock;
+    explicit MetricsRecorder(std::size_t statements);
+    void Prepared(std::size_t statement, Clock::time_point start);
+    void HandedOut(std::size_t statement);
+    void Stepped(std::size_t statement, Clock::time_point start, bool row,
+                 std::uint64_t bytes);
+    const StatementMetrics &operator[](std::size_t statement) const;
+
+   private:
+    std::vector<StatementMetrics> statements;
+    // When each statement was last handed out, while it is not stepped yet
+    std::vector<Clock::time_point> handed_out;
+    std::vector<bool> bound;
+};
+}  // namespace AddressBook
+
+#endif  // METRICS_HPP
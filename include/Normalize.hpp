@@ -0,0 +1,18 @@
+#ifndef NORMALIZE_HPP
+#define NORMALIZE_HPP
+
+#include <string>
+#include <string_view>
+
+namespace AddressBook {
+/**
+ * @brief Canonical forms of record fields, so that values typed differently
+ * compare equal. Only ASCII letters are case-folded.
+ */
+std::string FoldName(std::string_view name);
+std::string FoldEmail(std::string_view email);
+std::string TelephoneDigits(std::string_view telephone);
+std::string Soundex(std::string_view name);
+}  // namespace AddressBook
+
+#endif  // NORMALIZE_HPP
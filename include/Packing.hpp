@@ -0,0 +1,26 @@
+#ifndef PACKING_HPP
+#define PACKING_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace AddressBook {
+/**
+ * @brief Binary forms of the fields stored by a compressed Database.
+ * Telephones made of digits, spaces and `+-()` are packed two characters
+ * per byte. Emails are split at their last `@`, and the domain is replaced
+ * by the id of its row in a dictionary table. Both forms are lossless;
+ * values that do not fit them are stored as text.
+ */
+bool PackTelephone(std::string_view telephone, std::string &packed);
+bool UnpackTelephone(std::string_view packed, std::string &telephone);
+bool SplitEmail(std::string_view email, std::string_view &local,
+                std::string_view &domain);
+void PackEmail(std::int64_t domain_id, std::string_view local,
+               std::string &packed);
+bool UnpackEmail(std::string_view packed, std::int64_t &domain_id,
+                 std::string_view &local);
+}  // namespace AddressBook
+
+#endif  // PACKING_HPP
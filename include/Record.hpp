@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace AddressBook {
@@ -15,7 +16,23 @@ struct Record {
     Record() = default;
     Record(const std::vector<std::string> &params);
 };
-std::ostream& operator<<(std::ostream& os, Record record);
+
+/**
+ * @brief A non-owning view of a record. The fields point into memory owned
+ * by someone else, e.g. a query row, and are only valid as long as it is.
+ */
+struct RecordView {
+    int id = -1;
+    std::string_view first_name;
+    std::string_view last_name;
+    std::string_view email;
+    std::string_view telephone;
+    RecordView() = default;
+    RecordView(const Record &record);
+    Record ToRecord() const;
+};
+std::ostream& operator<<(std::ostream& os, const Record &record);
+std::ostream& operator<<(std::ostream& os, const RecordView &record);
 }  // namespace AddressBook
 
 #endif  // RECORD_HPP
@@ -0,0 +1,76 @@
+#ifndef RECORD_BATCH_HPP
+#define RECORD_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "Record.hpp"
+
+namespace AddressBook {
+/**
+ * @brief A columnar result set. The fields of all rows are stored back to
+ * back in one arena, and each row only keeps its id, the offset of its
+ * first field and the field lengths, so filling a batch allocates nothing
+ * once its capacity is reached. Rows are read back as RecordViews, which
+ * stay valid until the batch is modified.
+ */
+class RecordBatch {
+   public:
+    /**
+     * @brief Iterates over the rows of a batch as RecordViews
+     */
+    class Iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RecordView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = RecordView;
+        Iterator(const RecordBatch *batch, std::size_t index)
+            : batch(batch), index(index) {}
+        RecordView operator*() const { return (*this->batch)[this->index]; }
+        Iterator &operator++() {
+            this->index++;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy(*this);
+            this->index++;
+            return copy;
+        }
+        bool operator==(const Iterator &other) const {
+            return this->index == other.index;
+        }
+        bool operator!=(const Iterator &other) const {
+            return this->index != other.index;
+        }
+
+       private:
+        const RecordBatch *batch;
+        std::size_t index;
+    };
+
+    void Reserve(std::size_t rows, std::size_t arena_bytes);
+    void Append(const RecordView &record);
+    void Clear();
+    std::size_t Size() const;
+    bool Empty() const;
+    RecordView operator[](std::size_t i) const;
+    Iterator begin() const;
+    Iterator end() const;
+    std::size_t MemoryBytes() const;
+
+   private:
+    struct Row {
+        int id;
+        std::uint32_t lengths[4];  // first_name, last_name, email, telephone
+        std::size_t offset;        // Of first_name in the arena
+    };
+    std::vector<Row> rows;
+    std::string arena;
+};
+}  // namespace AddressBook
+
+#endif  // RECORD_BATCH_HPP
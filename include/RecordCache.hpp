@@ -0,0 +1,57 @@
+#ifndef RECORD_CACHE_HPP
+#define RECORD_CACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "Record.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Counters of a RecordCache
+ */
+struct CacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    std::size_t byte_budget = 0;
+};
+
+/**
+ * @brief An LRU cache of records keyed by rowid, with a secondary map from
+ * the folded (first_name, last_name) to the rowid returned for that name.
+ * The cache holds at most `byte_budget` bytes of records, as estimated by
+ * EntrySize, and evicts the least recently used records beyond that.
+ */
+class RecordCache {
+   public:
+    explicit RecordCache(std::size_t byte_budget);
+    bool FindByName(const std::string &first_name,
+                    const std::string &last_name, Record &record);
+    void Insert(const Record &record);
+    void EraseId(int rowid);
+    void EraseName(const std::string &first_name, const std::string &last_name);
+    void Clear();
+    CacheStats Stats() const;
+
+   private:
+    struct Entry {
+        Record record;
+        std::size_t size;  // EntrySize of the record when inserted
+    };
+    using Entries = std::list<Entry>;
+    static std::string NameKey(const std::string &first_name,
+                               const std::string &last_name);
+    static std::size_t EntrySize(const Record &record);
+    void Erase(Entries::iterator entry);
+    Entries entries;  // Most recently used first
+    std::unordered_map<int, Entries::iterator> by_id;
+    std::unordered_map<std::string, int> by_name;
+    CacheStats stats;
+};
+}  // namespace AddressBook
+
+#endif  // RECORD_CACHE_HPP
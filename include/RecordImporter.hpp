@@ -0,0 +1,67 @@
+#ifndef RECORD_IMPORTER_HPP
+#define RECORD_IMPORTER_HPP
+
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <string>
+#include <vector>
+#include "Database.hpp"
+#include "Record.hpp"
+
+namespace AddressBook {
+class ShardedDatabase;
+
+enum class ImportFormat { Csv, JsonLines };
+
+/**
+ * @brief The outcome of an import
+ */
+struct ImportResult {
+    std::size_t imported = 0;
+    std::size_t skipped = 0;
+    double seconds = 0;
+    std::vector<std::string> errors;  // The first few skipped rows
+};
+
+/**
+ * @brief Reads records one at a time from a CSV or JSON Lines stream.
+ * Rows that cannot be parsed into a record are skipped and counted.
+ */
+class RecordImporter {
+   public:
+    // The number of skipped rows kept in Errors()
+    static constexpr std::size_t kMaxErrors = 10;
+    // The number of lines a quoted CSV field may span after its first one
+    static constexpr std::size_t kMaxQuotedLines = 16;
+    RecordImporter(std::istream &input, ImportFormat format);
+    bool Next(Record &record);
+    std::size_t Skipped() const;
+    const std::vector<std::string> &Errors() const;
+    static ImportFormat FormatFromPath(const std::string &path);
+
+   private:
+    bool ParseCsv(const std::string &line, Record &record);
+    bool ParseJsonLine(const std::string &line, Record &record);
+    bool ReadLine(std::string &line);
+    void Skip(const std::string &reason);
+    std::istream &input;
+    // Lines read ahead for a quoted field, to be parsed again
+    std::deque<std::string> pending;
+    ImportFormat format;
+    std::size_t line_number = 0;
+    // Whether the CSV header has an id column before the fields
+    bool leading_id = false;
+    std::size_t skipped = 0;
+    std::vector<std::string> errors;
+};
+
+ImportResult ImportRecords(Database &db, std::istream &input,
+                           ImportFormat format,
+                           std::size_t batch_size = Database::kDefaultBatchSize);
+ImportResult ImportRecords(ShardedDatabase &db, std::istream &input,
+                           ImportFormat format,
+                           std::size_t batch_size = Database::kDefaultBatchSize);
+}  // namespace AddressBook
+
+#endif  // RECORD_IMPORTER_HPP
@@ -0,0 +1,53 @@
+#ifndef RECORD_WRITER_HPP
+#define RECORD_WRITER_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "Record.hpp"
+
+namespace AddressBook {
+enum class OutputFormat {
+    Text,      // The layout of operator<<, followed by a separator line
+    Table,     // One row per record in aligned columns
+    Csv,       // id,first_name,last_name,email,telephone with a header,
+               // readable by RecordImporter, which ignores the ids
+    JsonLines  // One JSON object per record, readable by RecordImporter
+};
+
+/**
+ * @brief Formats records into a large buffer and writes it to a stream in
+ * big chunks, so that printing many records costs a few writes instead of
+ * a flush per record. Records can be written straight from Database::Scan.
+ * The buffer is written out when full, by Flush, and on destruction.
+ */
+class RecordWriter {
+   public:
+    static constexpr std::size_t kDefaultBufferSize = 64 * 1024;
+    RecordWriter(std::ostream &os, OutputFormat format,
+                 std::size_t buffer_size = kDefaultBufferSize,
+                 bool flush_on_close = true);
+    RecordWriter(const RecordWriter &) = delete;
+    RecordWriter &operator=(const RecordWriter &) = delete;
+    ~RecordWriter();
+    void Write(const RecordView &record);
+    void Flush();
+    std::size_t Count() const;
+    static bool FormatFromName(const std::string &name, OutputFormat &format);
+
+   private:
+    void AppendCsvField(std::string_view field);
+    void AppendJsonString(std::string_view text);
+    void AppendPadded(std::string_view text, std::size_t width);
+    void Drain();
+    std::ostream &os;
+    OutputFormat format;
+    std::size_t buffer_size;
+    bool flush_on_close;
+    std::string buffer;
+    std::size_t count = 0;
+};
+}  // namespace AddressBook
+
+#endif  // RECORD_WRITER_HPP
@@ -0,0 +1,35 @@
+#ifndef SCRIPT_RUNNER_HPP
+#define SCRIPT_RUNNER_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Database.hpp"
+
+namespace AddressBook {
+/**
+ * @brief The outcome of a script
+ */
+struct ScriptResult {
+    std::size_t commands = 0;      // Commands run
+    std::size_t rows = 0;          // Rows added, updated or deleted
+    std::size_t transactions = 0;  // Transactions committed
+    std::size_t skipped = 0;       // Lines that were not valid commands
+    double seconds = 0;
+    // Set if a command failed in the database, which stopped the script
+    // and rolled back the commands since the last commit
+    bool aborted = false;
+    std::vector<std::string> errors;  // The first few skipped lines
+};
+
+// The number of skipped lines kept in ScriptResult::errors
+constexpr std::size_t kMaxScriptErrors = 10;
+
+bool SplitCommand(const std::string &line, std::vector<std::string> &words);
+ScriptResult RunScript(Database &db, std::istream &script, std::ostream &output,
+                       std::size_t batch_size = Database::kDefaultBatchSize);
+}  // namespace AddressBook
+
+#endif  // SCRIPT_RUNNER_HPP
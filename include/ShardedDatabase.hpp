@@ -0,0 +1,101 @@
+#ifndef SHARDED_DATABASE_HPP
+#define SHARDED_DATABASE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Database.hpp"
+#include "DatabaseOptions.hpp"
+#include "Record.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Contacts hash-partitioned by folded last name across several
+ * database files, so that writes to different shards run in parallel.
+ * Lookups by name go to one shard; the other queries run on all shards in
+ * parallel and merge their results.
+ *
+ * Record ids are global: a record with rowid `r` in shard `s` of `n` has
+ * the id `r * n + s`, which must fit in an int. Changing the last name of
+ * a record may move it to another shard and so change its id.
+ *
+ * It offers a deliberate subset of Database: adding, reading, deleting and
+ * updating single records, bulk adds, and clearing. Scan, paging, Search,
+ * UpdateRecords, DeleteRecords, the change log and transactions are left
+ * out, since they would need a global order or atomicity across shards.
+ *
+ * The class is thread-safe. Each shard is used by one thread at a time.
+ */
+class ShardedDatabase {
+   public:
+    // Replaced by the shard number in the uri template
+    static constexpr const char *kShardPlaceholder = "{shard}";
+    ShardedDatabase(const std::string &uri_template, std::size_t shards,
+                    const DatabaseOptions &options = DatabaseOptions());
+    ShardedDatabase(const ShardedDatabase &) = delete;
+    ShardedDatabase &operator=(const ShardedDatabase &) = delete;
+    std::size_t ShardCount() const;
+    std::size_t ShardOf(const std::string &last_name) const;
+    int AddRecord(const Record &record);
+    std::size_t AddRecords(const std::vector<Record> &records,
+                           std::size_t batch_size = Database::kDefaultBatchSize);
+    std::size_t AddRecords(const std::function<bool(Record &)> &next,
+                           std::size_t batch_size = Database::kDefaultBatchSize);
+    std::vector<Record> GetRecords(const Record &record) const;
+    Record GetRecordByName(const std::string &first_name,
+                           const std::string &last_name) const;
+    std::vector<Record> GetAllRecords() const;
+    int DeleteRecord(const std::string &first_name,
+                     const std::string &last_name);
+    int DeleteRecord(const Record &record);
+    int DeleteRecord(int id);
+    int UpdateRecord(int id, const Record &record, int *new_id = nullptr);
+    void ClearRecords();
+
+   private:
+    struct Shard {
+        std::unique_ptr<Database> db;
+        std::mutex mutex;
+    };
+
+    /**
+     * @brief Runs `operation` on every shard in parallel, each on its own
+     * thread while holding the lock of its shard.
+     *
+     * @param operation Called with the shard number and its Database
+     * @return The results of `operation` in shard order, if any
+     */
+    template <typename Operation>
+    auto ForEachShard(Operation operation) const {
+        using Result = std::invoke_result_t<Operation &, std::size_t, Database &>;
+        std::vector<std::future<Result>> futures;
+        for (std::size_t i = 0; i < this->shards.size(); i++) {
+            futures.push_back(std::async(std::launch::async, [this, i, &operation]() {
+                std::lock_guard<std::mutex> lock(this->shards[i]->mutex);
+                return operation(i, *this->shards[i]->db);
+            }));
+        }
+        if constexpr (std::is_void_v<Result>) {
+            for (auto &future : futures) {
+                future.get();
+            }
+        } else {
+            std::vector<Result> results;
+            for (auto &future : futures) {
+                results.push_back(future.get());
+            }
+            return results;
+        }
+    }
+    int GlobalId(std::size_t shard, int rowid) const;
+    std::vector<Record> Merge(std::vector<std::vector<Record>> results) const;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+}  // namespace AddressBook
+
+#endif  // SHARDED_DATABASE_HPP
@@ -0,0 +1,63 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Database.hpp"
+#include "Record.hpp"
+
+namespace AddressBook {
+/**
+ * @brief The outcome of saving or loading a snapshot
+ */
+struct SnapshotResult {
+    std::size_t records = 0;
+    std::uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+/**
+ * @brief A read-only view of a snapshot file. The file is memory-mapped and
+ * its records are read in place as RecordViews, which stay valid as long as
+ * the view.
+ *
+ * A snapshot is a 32-byte header followed by the records. All integers are
+ * little-endian.
+ *   header: magic "ABSNAP\0\0", u32 version, u32 reserved (0),
+ *           u64 record count, u64 FNV-1a checksum of everything after the
+ *           header
+ *   record: i32 id, u32 length of each of first_name, last_name, email
+ *           and telephone, then the four fields back to back
+ */
+class SnapshotView {
+   public:
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::size_t kHeaderSize = 32;
+    explicit SnapshotView(const std::string &path);
+    SnapshotView(const SnapshotView &) = delete;
+    SnapshotView &operator=(const SnapshotView &) = delete;
+    ~SnapshotView();
+    std::size_t Size() const;
+    RecordView operator[](std::size_t i) const;
+    std::uint64_t FileBytes() const;
+
+   private:
+    void Map(const std::string &path);
+    void Unmap();
+    void Validate(const std::string &path);
+    const char *data = nullptr;
+    std::size_t size = 0;
+    std::vector<std::size_t> offsets;  // Of each record in the file
+#ifdef _WIN32
+    void *mapping = nullptr;
+#endif
+};
+
+SnapshotResult SaveSnapshot(const Database &db, const std::string &path);
+SnapshotResult LoadSnapshot(Database &db, const std::string &path,
+                            std::size_t batch_size = Database::kDefaultBatchSize);
+}  // namespace AddressBook
+
+#endif  // SNAPSHOT_HPP
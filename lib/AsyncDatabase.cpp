@@ -0,0 +1,173 @@
+#include "AsyncDatabase.hpp"
+#include "DatabaseException.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Construct a new AsyncDatabase object. Opens the database on the
+ * worker thread and waits until it is open.
+ *
+ * @param uri The uri to the database
+ * @param options The settings of the connection
+ * @param async_options The settings of the write queue
+ * @throws DatabaseException If the database cannot be opened
+ */
+AsyncDatabase::AsyncDatabase(const std::string &uri,
+                             const DatabaseOptions &options,
+                             const AsyncOptions &async_options)
+    : async_options(async_options) {
+    std::promise<void> opened;
+    auto ready = opened.get_future();
+    this->worker = std::thread(&AsyncDatabase::Work, this, uri, options,
+                               std::move(opened));
+    try {
+        ready.get();
+    } catch (...) {
+        this->worker.join();
+        throw;
+    }
+}
+
+/**
+ * @brief Runs the operations still queued, then stops the worker thread.
+ */
+AsyncDatabase::~AsyncDatabase() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->queued.notify_one();
+    this->worker.join();
+}
+
+std::future<void> AsyncDatabase::AddRecord(Record record) {
+    return this->Write(
+        [record = std::move(record)](Database &db) { db.AddRecord(record); });
+}
+
+std::future<int> AsyncDatabase::UpdateRecord(int rowid, Record record) {
+    return this->Write([rowid, record = std::move(record)](Database &db) {
+        return db.UpdateRecord(rowid, record);
+    });
+}
+
+std::future<int> AsyncDatabase::DeleteRecord(int rowid) {
+    return this->Write(
+        [rowid](Database &db) { return db.DeleteRecord(rowid); });
+}
+
+std::future<Record> AsyncDatabase::GetRecordByName(std::string first_name,
+                                                   std::string last_name) {
+    return this->Read([first_name = std::move(first_name),
+                       last_name = std::move(last_name)](const Database &db) {
+        return db.GetRecordByName(first_name, last_name);
+    });
+}
+
+std::future<std::vector<Record>> AsyncDatabase::GetAllRecords() {
+    return this->Read([](const Database &db) { return db.GetAllRecords(); });
+}
+
+void AsyncDatabase::Enqueue(std::unique_ptr<Task> task) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->queue.push_back(std::move(task));
+    }
+    this->queued.notify_one();
+}
+
+/**
+ * @brief The loop of the worker thread. Takes either one read, or the run
+ * of writes at the front of the queue, and runs it.
+ */
+void AsyncDatabase::Work(const std::string &uri,
+                         const DatabaseOptions &options,
+                         std::promise<void> opened) {
+    std::unique_ptr<Database> db;
+    try {
+        db = std::make_unique<Database>(uri, options);
+    } catch (...) {
+        opened.set_exception(std::current_exception());
+        return;
+    }
+    opened.set_value();
+    std::vector<std::unique_ptr<Task>> group;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->queued.wait(lock, [this]() {
+                return this->stopping || !this->queue.empty();
+            });
+            if (this->queue.empty()) {
+                return;
+            }
+            std::size_t limit = this->async_options.group_commit
+                                    ? this->async_options.max_group_size
+                                    : 1;
+            do {
+                group.push_back(std::move(this->queue.front()));
+                this->queue.pop_front();
+            } while (group.size() < limit && group.front()->write &&
+                     !this->queue.empty() && this->queue.front()->write);
+        }
+        this->RunGroup(*db, group);
+        group.clear();
+    }
+}
+
+/**
+ * @brief Runs a read, a single write, or a group of writes in one
+ * transaction with a savepoint per write, then completes their futures.
+ */
+void AsyncDatabase::RunGroup(Database &db,
+                             std::vector<std::unique_ptr<Task>> &group) {
+    if (group.size() == 1) {
+        try {
+            group.front()->Run(db);
+        } catch (...) {
+            group.front()->error = std::current_exception();
+        }
+        group.front()->Complete();
+        return;
+    }
+    try {
+        Database::Transaction transaction(db);
+        std::size_t failed = group.size();
+        for (std::size_t i = 0; i < group.size(); i++) {
+            try {
+                Database::Transaction savepoint(db);
+                group[i]->Run(db);
+                savepoint.Commit();
+            } catch (...) {
+                group[i]->error = std::current_exception();
+                if (!transaction.Active()) {
+                    failed = i;
+                    break;
+                }
+            }
+        }
+        if (failed < group.size()) {
+            // SQLite rolled the whole group back, e.g. after SQLITE_FULL,
+            // so the writes before the failed one are gone too, and the
+            // ones after it are not run
+            auto error = std::make_exception_ptr(DatabaseException(
+                "The write was rolled back with its group after an error."));
+            for (std::size_t i = 0; i < group.size(); i++) {
+                if (i != failed) {
+                    group[i]->error = error;
+                }
+            }
+            transaction.Rollback();
+        } else {
+            transaction.Commit();
+        }
+    } catch (...) {
+        // The group was rolled back, so no write of it took effect
+        for (auto &task : group) {
+            task->error = std::current_exception();
+        }
+    }
+    for (auto &task : group) {
+        task->Complete();
+    }
+}
+}  // namespace AddressBook
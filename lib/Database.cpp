@@ -1,64 +1,265 @@
 #include "Database.hpp"
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <sstream>
 #include "DatabaseException.hpp"
+#include "Normalize.hpp"
+#include "Packing.hpp"
 
 namespace AddressBook {
+namespace {
+// How long Backup waits for a lock when the connection has no busy timeout
+const int kBackupBusyWaitMs = 1000;
+
+/**
+ * @brief Resets a cached statement and clears its bindings on scope exit,
+ * so that it releases its read lock and can be reused by the next call.
+ */
+class StatementReset {
+   public:
+    explicit StatementReset(sqlite3_stmt *stmt) : stmt(stmt) {}
+    StatementReset(const StatementReset &) = delete;
+    StatementReset &operator=(const StatementReset &) = delete;
+    ~StatementReset() {
+        sqlite3_reset(this->stmt);
+        sqlite3_clear_bindings(this->stmt);
+    }
+
+   private:
+    sqlite3_stmt *stmt;
+};
+
+/**
+ * @brief An SQL function applying `Fold` to its text argument, used to
+ * fill the key columns of existing rows.
+ */
+template <std::string (*Fold)(std::string_view)>
+void FoldFunction(sqlite3_context *context, int, sqlite3_value **argv) {
+    const char *text =
+        reinterpret_cast<const char *>(sqlite3_value_text(argv[0]));
+    if (text == nullptr) {
+        sqlite3_result_null(context);
+        return;
+    }
+    std::string folded = Fold(std::string_view(
+        text, static_cast<std::size_t>(sqlite3_value_bytes(argv[0]))));
+    sqlite3_result_text(context, folded.c_str(),
+                        static_cast<int>(folded.size()), SQLITE_TRANSIENT);
+}
+
+/**
+ * @brief Turns the words a user typed into an FTS5 query matching records
+ * that contain every word as a prefix of some token, e.g. `pet park` into
+ * `"pet"* "park"*`. Quoting keeps FTS5 operators in the input literal.
+ */
+std::string ToPrefixQuery(const std::string &terms) {
+    std::istringstream words(terms);
+    std::string word;
+    std::string query;
+    while (words >> word) {
+        if (!query.empty()) {
+            query += ' ';
+        }
+        query += '"';
+        for (char c : word) {
+            if (c == '"') {
+                query += '"';
+            }
+            query += c;
+        }
+        query += "\"*";
+    }
+    return query;
+}
+}  // namespace
+
 /**
  * @brief Construct a new Database:: Database object
  *
  * @param uri The uri to the database
+ * @param options The settings of the connection
  */
-Database::Database(const std::string& uri) {
-    int status_code = sqlite3_open_v2(
-        uri.c_str(), &(this->ppdb),
-        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI, NULL);
-    if (status_code != SQLITE_OK) {
-        throw DatabaseException(sqlite3_errmsg(this->ppdb));
+Database::Database(const std::string& uri, const DatabaseOptions& options) {
+    // A Database is used by one thread at a time, so SQLite's own
+    // per-connection mutex is not needed
+    int flags = SQLITE_OPEN_URI | SQLITE_OPEN_NOMUTEX |
+                (options.read_only
+                     ? SQLITE_OPEN_READONLY
+                     : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    int status_code = sqlite3_open_v2(uri.c_str(), &(this->ppdb), flags, NULL);
+    try {
+        if (status_code != SQLITE_OK) {
+            throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                    sqlite3_extended_errcode(this->ppdb));
+        }
+        this->ApplyOptions(options);
+        this->RegisterFunctions();
+        if (options.compressed && !options.read_only &&
+            !this->HasTable("contacts")) {
+            // Only a new database is compressed, so that all its rows are
+            // stored alike
+            this->Execute(
+                "CREATE TABLE contacts_email_domains ("
+                " id INTEGER PRIMARY KEY,"
+                " domain TEXT NOT NULL UNIQUE)");
+        }
+        this->compressed = this->HasTable("contacts_email_domains");
+        if (!options.read_only) {
+            this->CreateSchema();
+        }
+    } catch (...) {
+        this->FinalizeStatements();
+        sqlite3_close_v2(this->ppdb);
+        throw;
     }
-    this->CreateTableIfNotExists();
 }
 
 /**
  * @brief Add a new record to the database
  * 
  * @param record The record to be added
+ * @return int The id of the new record
  */
-void Database::AddRecord(const Record& record) {
-    const std::string sql("INSERT INTO contacts VALUES (?, ?, ?, ?)");
-    sqlite3_stmt* statement;
-    sqlite3_prepare_v2(this->ppdb, sql.c_str(), -1, &statement, NULL);
-    Database::BindStatement(record, statement);
-    if (sqlite3_step(statement) != SQLITE_DONE) {
-        throw DatabaseException("Failed to add the record.");
+int Database::AddRecord(const Record& record) {
+    sqlite3_stmt* statement = this->PrepareCached(
+        Statement::AddRecord,
+        "INSERT INTO contacts (first_name, last_name, email, telephone,"
+        " first_name_key, last_name_key, email_key, telephone_key)"
+        " VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    StatementReset reset(statement);
+    if (this->cache) {
+        this->cache->EraseName(record.first_name, record.last_name);
     }
-    sqlite3_finalize(statement);
+    this->BindStatement(record, statement);
+    Database::BindKeys(record, statement, 5);
+    if (this->Step(Statement::AddRecord) != SQLITE_DONE) {
+        throw DatabaseException("Failed to add the record.",
+                                sqlite3_extended_errcode(this->ppdb));
+    }
+    return static_cast<int>(sqlite3_last_insert_rowid(this->ppdb));
 }
 
 /**
- * @brief Search all records matching any of the fields in record.
+ * @brief Add a list of records, committing every `batch_size` rows in one
+ * transaction instead of one transaction per row.
+ *
+ * @param records The records to be added
+ * @param batch_size The number of rows per transaction
+ * @return std::size_t The number of records added
+ */
+std::size_t Database::AddRecords(const std::vector<Record> &records,
+                                 std::size_t batch_size) {
+    auto it = records.begin();
+    return this->AddRecords(
+        [&](Record &record) {
+            if (it == records.end()) {
+                return false;
+            }
+            record = *it++;
+            return true;
+        },
+        batch_size);
+}
+
+/**
+ * @brief Add records pulled from `next` until it returns false, committing
+ * every `batch_size` rows in one transaction. Records are inserted with
+ * one reused statement, so the source can stream rows of any count.
+ * If an insert fails, the open batch is rolled back and the exception is
+ * rethrown; batches committed before stay in the database.
+ *
+ * @param next Fills its argument with the next record, returns false when
+ * there are no more records
+ * @param batch_size The number of rows per transaction
+ * @return std::size_t The number of records added
+ */
+std::size_t Database::AddRecords(const std::function<bool(Record &)> &next,
+                                 std::size_t batch_size) {
+    Record record;
+    std::vector<int> batches = this->RunInBatches(
+        [&](int &changes) {
+            if (!next(record)) {
+                return false;
+            }
+            this->AddRecord(record);
+            changes = 1;
+            return true;
+        },
+        batch_size);
+    std::size_t added = 0;
+    for (int count : batches) {
+        added += count;
+    }
+    return added;
+}
+
+/**
+ * @brief Search all records matching any of the fields in record. Names
+ * and emails match ignoring case and extra whitespace, telephones ignoring
+ * everything but the digits.
  * 
  * @param record A record containing fields
  * @return std::vector<Record> The list of matching records
  */
 std::vector<Record> Database::GetRecords(const Record &record) const {
-    const std::string sql(
-        "SELECT *, ROWID FROM contacts WHERE first_name = ? OR"
-        " last_name = ? OR email = ? OR telephone = ?"
-        );
-    sqlite3_stmt *statement;
-    sqlite3_prepare_v2(this->ppdb, sql.c_str(), -1, &statement, NULL);
-    this->BindStatement(record, statement);
     std::vector<Record> records;
-    while (sqlite3_step(statement) == SQLITE_ROW) {
-        auto record = this->GetRecordFromRow(statement);
-        record.id = sqlite3_column_int(statement, 5);
-        records.push_back(record);
-    }
-    sqlite3_finalize(statement);
+    this->Scan(record, [&](const RecordView &view) {
+        records.push_back(view.ToRecord());
+        return true;
+    });
     return records;
 }
 
 /**
- * @brief Returns the first record that matches both first name and last name
+ * @brief Search all records matching any of the fields in record, filling
+ * `batch` instead of allocating a Record per row.
+ * 
+ * @param record A record containing fields
+ * @param batch Cleared, then filled with the matching records. Its memory
+ * is reused, so refilling the same batch allocates nothing once it is
+ * large enough.
+ */
+void Database::GetRecords(const Record &record, RecordBatch &batch) const {
+    batch.Clear();
+    this->Scan(record, [&](const RecordView &view) {
+        batch.Append(view);
+        return true;
+    });
+}
+
+/**
+ * @brief Visits all records matching any of the fields in record, straight
+ * from the query without materializing the result.
+ * The views passed to `visitor` are only valid during the call, and
+ * `visitor` must not call Scan or GetRecords on this database.
+ *
+ * @param record A record containing fields
+ * @param visitor Called for every matching record, returns false to stop
+ * @return std::size_t The number of records visited
+ */
+std::size_t Database::Scan(const Record &record,
+                           const RecordVisitor &visitor) const {
+    // One index lookup per key instead of a full scan for the OR
+    sqlite3_stmt *statement = this->PrepareCached(
+        Statement::GetRecords,
+        "SELECT first_name, last_name, email, telephone, ROWID FROM contacts"
+        " WHERE first_name_key = ?1"
+        " UNION SELECT first_name, last_name, email, telephone, ROWID"
+        " FROM contacts WHERE last_name_key = ?2"
+        " UNION SELECT first_name, last_name, email, telephone, ROWID"
+        " FROM contacts WHERE email_key = ?3"
+        " UNION SELECT first_name, last_name, email, telephone, ROWID"
+        " FROM contacts WHERE telephone_key = ?4"
+        " ORDER BY 5");
+    StatementReset reset(statement);
+    Database::BindKeys(record, statement, 1);
+    return this->ScanStatement(Statement::GetRecords, visitor);
+}
+
+/**
+ * @brief Returns the first record that matches both first name and last
+ * name, ignoring case and extra whitespace
  *
  * @param first_name The first name
  * @param last_name The last name
@@ -67,18 +268,26 @@ std::vector<Record> Database::GetRecords(const Record &record) const {
  */
 Record Database::GetRecordByName(const std::string& first_name,
                                  const std::string& last_name) const {
-    const std::string sql(
-        "SELECT *, ROWID FROM contacts WHERE first_name = ? AND last_name = ?");
-    sqlite3_stmt* statement;
-    sqlite3_prepare_v2(this->ppdb, sql.c_str(), -1, &statement, NULL);
-    sqlite3_bind_text(statement, 1, first_name.c_str(), -1, NULL);
-    sqlite3_bind_text(statement, 2, last_name.c_str(), -1, NULL);
     Record record;
-    if (sqlite3_step(statement) == SQLITE_ROW) {
+    if (this->cache &&
+        this->cache->FindByName(first_name, last_name, record)) {
+        return record;
+    }
+    sqlite3_stmt* statement = this->PrepareCached(
+        Statement::GetRecordByName,
+        "SELECT first_name, last_name, email, telephone, ROWID FROM contacts"
+        " WHERE first_name_key = ? AND last_name_key = ?");
+    StatementReset reset(statement);
+    const std::string first_name_key = FoldName(first_name);
+    const std::string last_name_key = FoldName(last_name);
+    sqlite3_bind_text(statement, 1, first_name_key.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(statement, 2, last_name_key.c_str(), -1, SQLITE_STATIC);
+    if (this->Step(Statement::GetRecordByName) == SQLITE_ROW) {
         record = this->GetRecordFromRow(statement);
-        record.id = sqlite3_column_int(statement, 4);
+        if (this->cache) {
+            this->cache->Insert(record);
+        }
     }
-    sqlite3_finalize(statement);
     return record;
 }
 
@@ -89,58 +298,181 @@ Record Database::GetRecordByName(const std::string& first_name,
  */
 std::vector<Record> Database::GetAllRecords() const {
     std::vector<Record> records;
-    sqlite3_exec(this->ppdb, "SELECT *, ROWID FROM contacts",
-                 &(Database::GetAllRecordsCallback), &records, NULL);
+    this->Scan([&](const RecordView &view) {
+        records.push_back(view.ToRecord());
+        return true;
+    });
+    return records;
+}
+
+/**
+ * @brief Get all records in the database, filling `batch` instead of
+ * allocating a Record per row.
+ * 
+ * @param batch Cleared, then filled with all records. Its memory is
+ * reused, so refilling the same batch allocates nothing once it is large
+ * enough.
+ */
+void Database::GetAllRecords(RecordBatch &batch) const {
+    batch.Clear();
+    this->Scan([&](const RecordView &view) {
+        batch.Append(view);
+        return true;
+    });
+}
+
+/**
+ * @brief Get a page of at most `limit` records following the record
+ * `after_rowid` in `order`. The page is found by seeking in the rowid or
+ * name index (keyset pagination), so every page costs the same however
+ * far into the table it is.
+ *
+ * @param after_rowid The id of the last record of the previous page, or 0
+ * for the first page. With PageOrder::Name the record must still exist.
+ * @param limit The maximum number of records in the page
+ * @param order The order to page through the records in
+ * @return std::vector<Record> The records of the page. A page shorter than
+ * `limit` is the last page.
+ */
+std::vector<Record> Database::GetRecordsPage(int after_rowid, int limit,
+                                             PageOrder order) const {
+    Statement key;
+    sqlite3_stmt *statement;
+    if (order == PageOrder::Rowid) {
+        key = Statement::PageByRowid;
+        statement = this->PrepareCached(
+            key,
+            "SELECT first_name, last_name, email, telephone, ROWID"
+            " FROM contacts WHERE ROWID > ?1 ORDER BY ROWID LIMIT ?2");
+    } else if (after_rowid <= 0) {
+        key = Statement::FirstPageByName;
+        statement = this->PrepareCached(
+            key,
+            "SELECT first_name, last_name, email, telephone, ROWID"
+            " FROM contacts ORDER BY last_name, first_name, ROWID LIMIT ?2");
+    } else {
+        key = Statement::PageByName;
+        statement = this->PrepareCached(
+            key,
+            "SELECT first_name, last_name, email, telephone, ROWID"
+            " FROM contacts WHERE (last_name, first_name, ROWID) >"
+            " (SELECT last_name, first_name, ROWID FROM contacts"
+            "  WHERE ROWID = ?1)"
+            " ORDER BY last_name, first_name, ROWID LIMIT ?2");
+    }
+    StatementReset reset(statement);
+    sqlite3_bind_int(statement, 1, after_rowid);
+    sqlite3_bind_int(statement, 2, limit);
+    std::vector<Record> records;
+    records.reserve(limit > 0 ? limit : 0);
+    this->ScanStatement(key, [&](const RecordView &view) {
+        records.push_back(view.ToRecord());
+        return true;
+    });
+    return records;
+}
+
+/**
+ * @brief Search records by prefixes of the words in their fields, ranked
+ * by relevance with matches in names ranked above matches in email and
+ * telephone. Every word of `query` must match, e.g. "pet park" finds
+ * Peter O' Parker.
+ *
+ * @param query The words to search for, separated by spaces
+ * @param limit The maximum number of records returned
+ * @return std::vector<Record> The matching records, best match first
+ * @throws DatabaseException If SQLite was built without FTS5
+ */
+std::vector<Record> Database::Search(const std::string &query,
+                                     int limit) const {
+    std::vector<Record> records;
+    std::string match = ToPrefixQuery(query);
+    if (match.empty()) {
+        return records;
+    }
+    if (!this->HasFullTextSearch()) {
+        throw DatabaseException(
+            "Full-text search is not available: SQLite was built without "
+            "FTS5.");
+    }
+    sqlite3_stmt *statement = this->PrepareCached(
+        Statement::Search,
+        "SELECT first_name, last_name, email, telephone, rowid"
+        " FROM contacts_fts WHERE contacts_fts MATCH ?1"
+        " ORDER BY bm25(contacts_fts, 4.0, 4.0, 2.0, 1.0) LIMIT ?2");
+    StatementReset reset(statement);
+    sqlite3_bind_text(statement, 1, match.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(statement, 2, limit);
+    this->ScanStatement(Statement::Search, [&](const RecordView &view) {
+        records.push_back(view.ToRecord());
+        return true;
+    });
     return records;
 }
 
 /**
- * @brief Deletes all records with matching first name and last name
+ * @return bool Whether the full-text index used by Search exists. It is
+ * only created when SQLite is built with FTS5.
+ */
+bool Database::HasFullTextSearch() const {
+    return this->HasTable("contacts_fts");
+}
+
+/**
+ * @brief Visits all records in the database straight from the query, so
+ * memory use does not grow with the size of the table.
+ * The views passed to `visitor` are only valid during the call, and
+ * `visitor` must not call Scan or GetAllRecords on this database.
+ *
+ * @param visitor Called for every record, returns false to stop
+ * @return std::size_t The number of records visited
+ */
+std::size_t Database::Scan(const RecordVisitor &visitor) const {
+    sqlite3_stmt *statement = this->PrepareCached(
+        Statement::GetAllRecords,
+        "SELECT first_name, last_name, email, telephone, ROWID FROM contacts");
+    StatementReset reset(statement);
+    return this->ScanStatement(Statement::GetAllRecords, visitor);
+}
+
+/**
+ * @brief Deletes all records with matching first name and last name,
+ * ignoring case and extra whitespace like GetRecordByName
  * 
  * @param first_name The first name
  * @param last_name The last name
  * @return int The number of records affected.
  */
 int Database::DeleteRecord(const std::string &first_name, const std::string &last_name) {
-    std::string query("DELETE FROM contacts WHERE first_name = ? AND last_name = ?");
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(this->ppdb, query.c_str(), -1, &stmt, NULL);
-    Database::BindStatementText(stmt, {first_name, last_name});
-    // sqlite3_bind_text(stmt, 1, first_name.c_str(), -1, SQLITE_STATIC);
-    // sqlite3_bind_text(stmt, 2, last_name.c_str(), -1, SQLITE_STATIC);
-    std::string expanded_sql(sqlite3_expanded_sql(stmt));
-    int status = sqlite3_step(stmt);
-    if (status != SQLITE_DONE) {
-        throw DatabaseException(sqlite3_errstr(status));
+    sqlite3_stmt *stmt = this->PrepareCached(
+        Statement::DeleteByName,
+        "DELETE FROM contacts WHERE first_name_key = ? AND last_name_key = ?");
+    StatementReset reset(stmt);
+    if (this->cache) {
+        this->cache->EraseName(first_name, last_name);
     }
-    int rows_affected = sqlite3_changes(this->ppdb);
-    sqlite3_finalize(stmt);
-    return rows_affected;
+    Database::BindStatementText(stmt, {FoldName(first_name), FoldName(last_name)});
+    return this->StepAndCountChanges(Statement::DeleteByName);
 }
 
 /**
- * @brief Deletes a record that is a full match with `record`
+ * @brief Deletes the records matching all fields of `record`, compared by
+ * their folded keys like GetRecords, e.g. "9384 6572" matches "93846572"
  * 
  * @param record The record to be removed from the database
  * @return int The number of rows affected
  */
 int Database::DeleteRecord(const Record &record) {
-    // TODO: This function is very similar in steps with DeleteRecord(const std::string, const std::string)
-    //       alter the function so that it is less verbose
-    std::string query(
-        "DELETE FROM contacts WHERE first_name = ? "
-        "AND last_name = ? AND email = ? AND telephone = ?"
-    );
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(this->ppdb, query.c_str(), -1, &stmt, NULL);
-    Database::BindStatement(record, stmt);
-    int status = sqlite3_step(stmt);
-    if (status != SQLITE_DONE) {
-        throw DatabaseException(sqlite3_errstr(status));
+    sqlite3_stmt *stmt = this->PrepareCached(
+        Statement::DeleteByDetails,
+        "DELETE FROM contacts WHERE first_name_key = ?1"
+        " AND last_name_key = ?2 AND email_key = ?3 AND telephone_key = ?4");
+    StatementReset reset(stmt);
+    if (this->cache) {
+        this->cache->EraseName(record.first_name, record.last_name);
     }
-    int rows_affected = sqlite3_changes(this->ppdb);
-    sqlite3_finalize(stmt);
-    return rows_affected;
+    Database::BindKeys(record, stmt, 1);
+    return this->StepAndCountChanges(Statement::DeleteByDetails);
 }
 
 /**
@@ -149,14 +481,14 @@ int Database::DeleteRecord(const Record &record) {
  * @return The number of rows affected. Generally either 0 or 1.
 */
 int Database::DeleteRecord(int rowid) {
-    const std::string sql("DELETE FROM contacts WHERE ROWID = ?");
-    sqlite3_stmt *stmt;
-    sqlite3_prepare_v2(this->ppdb, sql.c_str(), -1, &stmt, nullptr);
+    sqlite3_stmt *stmt = this->PrepareCached(
+        Statement::DeleteById, "DELETE FROM contacts WHERE ROWID = ?");
+    StatementReset reset(stmt);
+    if (this->cache) {
+        this->cache->EraseId(rowid);
+    }
     sqlite3_bind_int(stmt, 1, rowid);
-    sqlite3_step(stmt);
-    int rows_affected = sqlite3_changes(this->ppdb);
-    sqlite3_finalize(stmt);
-    return rows_affected;
+    return this->StepAndCountChanges(Statement::DeleteById);
 }
 
 /**
@@ -167,18 +499,72 @@ int Database::DeleteRecord(int rowid) {
 */
 int Database::UpdateRecord(int rowid, const Record& record) const
 {
-    const std::string query(
-        "UPDATE contacts SET first_name = ?, last_name = ?,"
-        " email = ?, telephone = ? WHERE ROWID = ?"
-    );
-    sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(this->ppdb, query.c_str(), -1, &stmt, NULL);
-    Database::BindStatement(record, stmt);
+    sqlite3_stmt* stmt = this->PrepareCached(
+        Statement::UpdateRecord,
+        "UPDATE contacts SET first_name = ?1, last_name = ?2,"
+        " email = ?3, telephone = ?4, first_name_key = ?6,"
+        " last_name_key = ?7, email_key = ?8, telephone_key = ?9"
+        " WHERE ROWID = ?5");
+    StatementReset reset(stmt);
+    if (this->cache) {
+        // The record may also become the first match of its new name
+        this->cache->EraseId(rowid);
+        this->cache->EraseName(record.first_name, record.last_name);
+    }
+    this->BindStatement(record, stmt);
     sqlite3_bind_int(stmt, 5, rowid);
-    sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    return sqlite3_changes(this->ppdb);
-    
+    Database::BindKeys(record, stmt, 6);
+    return this->StepAndCountChanges(Statement::UpdateRecord);
+}
+
+/**
+ * @brief Updates many records by their rowids, `batch_size` rows per
+ * transaction, with one reused statement.
+ * If an update fails, the open batch is rolled back and the exception is
+ * rethrown; batches committed before stay in the database.
+ *
+ * @param updates Pairs of the rowid and the new values of a record
+ * @param batch_size The number of rows per transaction
+ * @return std::vector<int> The number of rows affected by each batch
+ */
+std::vector<int> Database::UpdateRecords(
+    const std::vector<std::pair<int, Record>> &updates,
+    std::size_t batch_size) {
+    auto it = updates.begin();
+    return this->RunInBatches(
+        [&](int &changes) {
+            if (it == updates.end()) {
+                return false;
+            }
+            changes = this->UpdateRecord(it->first, it->second);
+            ++it;
+            return true;
+        },
+        batch_size);
+}
+
+/**
+ * @brief Deletes many records by their rowids, `batch_size` rows per
+ * transaction, with one reused statement.
+ * If a delete fails, the open batch is rolled back and the exception is
+ * rethrown; batches committed before stay in the database.
+ *
+ * @param rowids The rowids of the records to delete
+ * @param batch_size The number of rows per transaction
+ * @return std::vector<int> The number of rows affected by each batch
+ */
+std::vector<int> Database::DeleteRecords(const std::vector<int> &rowids,
+                                         std::size_t batch_size) {
+    auto it = rowids.begin();
+    return this->RunInBatches(
+        [&](int &changes) {
+            if (it == rowids.end()) {
+                return false;
+            }
+            changes = this->DeleteRecord(*it++);
+            return true;
+        },
+        batch_size);
 }
 
 /**
@@ -187,86 +573,1137 @@ int Database::UpdateRecord(int rowid, const Record& record) const
 */
 void Database::ClearRecords()
 {
-    // Drop the table and create a new one
-    const std::string sql("DROP TABLE contacts");
-    int status_code = sqlite3_exec(
-        this->ppdb, sql.c_str(), nullptr, nullptr, nullptr);
-    if (status_code != SQLITE_OK) {
-        throw DatabaseException(sqlite3_errstr(status_code));
-    }
-    this->CreateTableIfNotExists();
-}
-
-void Database::CreateTableIfNotExists() {
-    // sqlite3_stmt *statement;
-    // sqlite3_prepare_v2(this->ppdb, this->table_def.c_str(), -1, &statement,
-    // NULL);
-    int status =
-        sqlite3_exec(this->ppdb, this->table_def.c_str(), NULL, NULL, NULL);
+    // Drop the table and create a new one. The indexes are dropped with
+    // the table, so the new table is migrated from version 0 again.
+    if (this->cache) {
+        this->cache->Clear();
+    }
+    Transaction transaction(*this);
+    this->Execute("DROP TABLE contacts");
+    this->Execute("PRAGMA user_version = 0");
+    this->CreateSchema();
+    // Dropping the table fires no delete triggers
+    this->Execute(
+        "INSERT INTO contacts_changes (operation) VALUES ('clear')");
+    transaction.Commit();
+}
+
+/**
+ * @brief Returns the changes made after `sequence`, oldest first, so that
+ * a mirror can catch up by reading only what changed. Pass the sequence of
+ * the last change returned to get the next ones.
+ *
+ * @param sequence The sequence of the last change already seen, 0 for all
+ * @param limit The maximum number of changes returned
+ * @return std::vector<Change> The changes. Fewer than `limit` means the
+ * mirror has caught up.
+ * @throws DatabaseException If changes after `sequence` were compacted
+ * away, in which case the mirror has to be rebuilt from GetAllRecords
+ * and LatestChange
+ */
+std::vector<Change> Database::ChangesSince(std::int64_t sequence,
+                                           int limit) const {
+    sqlite3_stmt *oldest = this->PrepareCached(
+        Statement::OldestChange,
+        "SELECT COALESCE((SELECT MIN(sequence) - 1 FROM contacts_changes),"
+        " (SELECT seq FROM sqlite_sequence"
+        "  WHERE name = 'contacts_changes'), 0)");
+    {
+        StatementReset reset(oldest);
+        if (this->Step(Statement::OldestChange) != SQLITE_ROW) {
+            throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                    sqlite3_extended_errcode(this->ppdb));
+        }
+        if (sequence < sqlite3_column_int64(oldest, 0)) {
+            throw DatabaseException(
+                "The changes after " + std::to_string(sequence) +
+                " were compacted. Read all records again.");
+        }
+    }
+    sqlite3_stmt *statement = this->PrepareCached(
+        Statement::ChangesSince,
+        "SELECT first_name, last_name, email, telephone, record_id,"
+        " sequence, operation FROM contacts_changes"
+        " WHERE sequence > ?1 ORDER BY sequence LIMIT ?2");
+    StatementReset reset(statement);
+    sqlite3_bind_int64(statement, 1, sequence);
+    sqlite3_bind_int(statement, 2, limit);
+    std::vector<Change> changes;
+    this->ScanStatement(Statement::ChangesSince, [&](const RecordView &view) {
+        Change change;
+        change.sequence = sqlite3_column_int64(statement, 5);
+        const char *operation =
+            reinterpret_cast<const char *>(sqlite3_column_text(statement, 6));
+        std::string_view type(operation == nullptr ? "" : operation);
+        change.type = type == "insert"   ? ChangeType::Insert
+                      : type == "update" ? ChangeType::Update
+                      : type == "delete" ? ChangeType::Delete
+                                         : ChangeType::Clear;
+        change.record = view.ToRecord();
+        if (change.type == ChangeType::Clear) {
+            change.record.id = -1;
+        }
+        changes.push_back(std::move(change));
+        return true;
+    });
+    return changes;
+}
+
+/**
+ * @return std::int64_t The sequence of the latest change, 0 if there was
+ * none. A mirror built from GetAllRecords in the same transaction follows
+ * the feed from there.
+ */
+std::int64_t Database::LatestChange() const {
+    sqlite3_stmt *statement = this->PrepareCached(
+        Statement::LatestChange,
+        "SELECT COALESCE((SELECT seq FROM sqlite_sequence"
+        " WHERE name = 'contacts_changes'), 0)");
+    StatementReset reset(statement);
+    if (this->Step(Statement::LatestChange) != SQLITE_ROW) {
+        throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                sqlite3_extended_errcode(this->ppdb));
+    }
+    return sqlite3_column_int64(statement, 0);
+}
+
+/**
+ * @brief Removes the changes up to `through_sequence`, once every mirror
+ * has read them. Sequences are never reused.
+ *
+ * @param through_sequence The sequence of the last change removed
+ * @return int The number of changes removed
+ */
+int Database::CompactChanges(std::int64_t through_sequence) {
+    sqlite3_stmt *stmt = this->PrepareCached(
+        Statement::CompactChanges,
+        "DELETE FROM contacts_changes WHERE sequence <= ?");
+    StatementReset reset(stmt);
+    sqlite3_bind_int64(stmt, 1, through_sequence);
+    return this->StepAndCountChanges(Statement::CompactChanges);
+}
+
+/**
+ * @brief Puts an LRU cache in front of GetRecordByName. All the methods
+ * changing records keep it coherent. Replaces the current cache, if any.
+ *
+ * @param byte_budget The maximum estimated size of the cached records
+ */
+void Database::EnableCache(std::size_t byte_budget) {
+    this->cache = std::make_unique<RecordCache>(byte_budget);
+}
+
+/**
+ * @brief Removes the cache in front of GetRecordByName, if any.
+ */
+void Database::DisableCache() {
+    this->cache.reset();
+}
+
+/**
+ * @return CacheStats The counters of the cache, all zero if it is disabled
+ */
+CacheStats Database::GetCacheStats() const {
+    return this->cache ? this->cache->Stats() : CacheStats();
+}
+
+/**
+ * @brief Applies the connection settings in `options`. The page size is
+ * set first, since it cannot change once the file is in WAL mode.
+ * @throws DatabaseException If a setting has an unknown value
+ */
+void Database::ApplyOptions(const DatabaseOptions &options) {
+    // Only known keywords are spliced into the pragmas
+    auto keyword = [](const char *name, const std::string &value,
+                      std::initializer_list<const char *> allowed) {
+        for (const char *candidate : allowed) {
+            if (value == candidate) {
+                return std::string("PRAGMA ") + name + " = " + value;
+            }
+        }
+        throw DatabaseException("Unknown " + std::string(name) + " \"" +
+                                value + "\".");
+    };
+    sqlite3_busy_timeout(this->ppdb, options.busy_timeout_ms);
+    if (options.page_size) {
+        this->Execute(
+            ("PRAGMA page_size = " + std::to_string(*options.page_size))
+                .c_str());
+    }
+    if (!options.journal_mode.empty()) {
+        this->Execute(keyword("journal_mode", options.journal_mode,
+                              {"delete", "truncate", "persist", "memory",
+                               "wal", "off"})
+                          .c_str());
+    }
+    if (!options.synchronous.empty()) {
+        this->Execute(keyword("synchronous", options.synchronous,
+                              {"off", "normal", "full", "extra"})
+                          .c_str());
+    }
+    if (options.cache_size) {
+        this->Execute(
+            ("PRAGMA cache_size = " + std::to_string(*options.cache_size))
+                .c_str());
+    }
+    if (options.mmap_size) {
+        this->Execute(
+            ("PRAGMA mmap_size = " + std::to_string(*options.mmap_size))
+                .c_str());
+    }
+    if (!options.temp_store.empty()) {
+        this->Execute(keyword("temp_store", options.temp_store,
+                              {"default", "file", "memory"})
+                          .c_str());
+    }
+}
+
+/**
+ * @brief Registers the SQL functions unpack_email and unpack_telephone,
+ * which return the text of a field stored packed by BindStatement and
+ * any other value as it is. The full-text triggers of a compressed
+ * database use them to index the fields as text.
+ */
+void Database::RegisterFunctions() {
+    auto unpack_email = [](sqlite3_context *context, int,
+                           sqlite3_value **argv) {
+        if (sqlite3_value_type(argv[0]) != SQLITE_BLOB) {
+            sqlite3_result_value(context, argv[0]);
+            return;
+        }
+        const auto *db =
+            static_cast<const Database *>(sqlite3_user_data(context));
+        std::string email;
+        try {
+            db->UnpackEmailField(
+                std::string_view(
+                    static_cast<const char *>(sqlite3_value_blob(argv[0])),
+                    static_cast<std::size_t>(sqlite3_value_bytes(argv[0]))),
+                email);
+        } catch (const DatabaseException &e) {
+            sqlite3_result_error(context, e.what(), -1);
+            return;
+        }
+        sqlite3_result_text(context, email.c_str(),
+                            static_cast<int>(email.size()), SQLITE_TRANSIENT);
+    };
+    auto unpack_telephone = [](sqlite3_context *context, int,
+                               sqlite3_value **argv) {
+        if (sqlite3_value_type(argv[0]) != SQLITE_BLOB) {
+            sqlite3_result_value(context, argv[0]);
+            return;
+        }
+        std::string telephone;
+        if (!UnpackTelephone(
+                std::string_view(
+                    static_cast<const char *>(sqlite3_value_blob(argv[0])),
+                    static_cast<std::size_t>(sqlite3_value_bytes(argv[0]))),
+                telephone)) {
+            sqlite3_result_error(context, "Corrupt packed telephone.", -1);
+            return;
+        }
+        sqlite3_result_text(context, telephone.c_str(),
+                            static_cast<int>(telephone.size()),
+                            SQLITE_TRANSIENT);
+    };
+    sqlite3_create_function(this->ppdb, "unpack_email", 1, SQLITE_UTF8, this,
+                            unpack_email, nullptr, nullptr);
+    sqlite3_create_function(this->ppdb, "unpack_telephone", 1,
+                            SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr,
+                            unpack_telephone, nullptr, nullptr);
+}
+
+/**
+ * @return bool Whether the table or virtual table `name` exists
+ */
+bool Database::HasTable(const char *name) const {
+    return sqlite3_table_column_metadata(this->ppdb, nullptr, name, nullptr,
+                                         nullptr, nullptr, nullptr, nullptr,
+                                         nullptr) == SQLITE_OK;
+}
+
+/**
+ * @brief Starts recording the prepares and steps of every statement,
+ * clearing the metrics recorded so far.
+ *
+ * @throws DatabaseException If the library was built without
+ * ADDRESS_BOOK_METRICS
+ */
+void Database::EnableMetrics() {
+#ifdef ADDRESS_BOOK_METRICS
+    this->metrics = std::make_unique<MetricsRecorder>(this->statements.size());
+#else
+    throw DatabaseException(
+        "Metrics are not available: the library was built without "
+        "ADDRESS_BOOK_METRICS.");
+#endif
+}
+
+/**
+ * @brief Stops recording metrics and discards them.
+ */
+void Database::DisableMetrics() {
+    this->metrics.reset();
+}
+
+/**
+ * @return MetricsReport The metrics of the statements prepared while
+ * metrics were enabled, and the counters SQLite keeps for the connection
+ */
+MetricsReport Database::GetMetrics() const {
+    static const char *const names[] = {
+        "AddRecord",     "GetRecords",      "GetRecordByName",
+        "GetAllRecords", "PageByRowid",     "FirstPageByName",
+        "PageByName",    "Search",          "DeleteByName",
+        "DeleteByDetails", "DeleteById",    "UpdateRecord",
+        "ChangesSince",  "OldestChange",    "LatestChange",
+        "CompactChanges", "FindDomain",     "AddDomain",
+        "GetDomain"};
+    static_assert(std::size(names) == static_cast<std::size_t>(Statement::Count),
+                  "Every statement needs a name");
+    MetricsReport report;
+    if (this->metrics) {
+        for (std::size_t i = 0; i < this->statements.size(); i++) {
+            const StatementMetrics &statement = (*this->metrics)[i];
+            if (statement.prepares > 0 || statement.executions > 0) {
+                report.statements.emplace_back(names[i], statement);
+            }
+        }
+    }
+    int highwater;
+    sqlite3_db_status(this->ppdb, SQLITE_DBSTATUS_CACHE_HIT,
+                      &report.sqlite.cache_hits, &highwater, 0);
+    sqlite3_db_status(this->ppdb, SQLITE_DBSTATUS_CACHE_MISS,
+                      &report.sqlite.cache_misses, &highwater, 0);
+    sqlite3_db_status(this->ppdb, SQLITE_DBSTATUS_CACHE_WRITE,
+                      &report.sqlite.cache_writes, &highwater, 0);
+    sqlite3_db_status(this->ppdb, SQLITE_DBSTATUS_CACHE_USED,
+                      &report.sqlite.cache_used_bytes, &highwater, 0);
+    sqlite3_db_status(this->ppdb, SQLITE_DBSTATUS_SCHEMA_USED,
+                      &report.sqlite.schema_used_bytes, &highwater, 0);
+    sqlite3_db_status(this->ppdb, SQLITE_DBSTATUS_STMT_USED,
+                      &report.sqlite.statement_used_bytes, &highwater, 0);
+    return report;
+}
+
+/**
+ * @brief Reads back the settings the connection actually runs with, which
+ * may differ from the requested ones, e.g. an in-memory database is never
+ * in WAL mode.
+ *
+ * @return DatabaseOptions The effective settings
+ */
+DatabaseOptions Database::GetEffectiveOptions() const {
+    static const char *const synchronous[] = {"off", "normal", "full",
+                                              "extra"};
+    static const char *const temp_store[] = {"default", "file", "memory"};
+    DatabaseOptions options;
+    options.read_only = sqlite3_db_readonly(this->ppdb, "main") == 1;
+    options.busy_timeout_ms = std::stoi(this->QueryPragma("busy_timeout"));
+    options.journal_mode = this->QueryPragma("journal_mode");
+    options.synchronous =
+        synchronous[std::stoi(this->QueryPragma("synchronous")) & 3];
+    options.cache_size = std::stoi(this->QueryPragma("cache_size"));
+    options.mmap_size = std::stoll(this->QueryPragma("mmap_size"));
+    options.temp_store =
+        temp_store[std::stoi(this->QueryPragma("temp_store")) % 3];
+    options.page_size = std::stoi(this->QueryPragma("page_size"));
+    options.compressed = this->compressed;
+    return options;
+}
+
+/**
+ * @brief Copies the database to `uri` with the online backup API. The copy
+ * is made a few pages at a time, and the read lock on this database is only
+ * held during each step, so other connections keep reading and writing in
+ * between. If the source changes, the copy restarts to stay consistent.
+ * A step waits for a lock held by another connection for at most the busy
+ * timeout of this connection, or kBackupBusyWaitMs if it has none.
+ *
+ * @param uri The uri of the backup, overwritten if it exists
+ * @param pages_per_step The number of pages copied per step
+ * @throws DatabaseException If the backup cannot be opened or written, or
+ * a lock is held for longer than the wait
+ */
+void Database::Backup(const std::string &uri, int pages_per_step) const {
+    sqlite3 *target;
+    int status = sqlite3_open_v2(
+        uri.c_str(), &target,
+        SQLITE_OPEN_URI | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
     if (status != SQLITE_OK) {
-        throw DatabaseException(sqlite3_errstr(status));
+        DatabaseException error(sqlite3_errmsg(target),
+                                sqlite3_extended_errcode(target));
+        sqlite3_close_v2(target);
+        throw error;
+    }
+    sqlite3_backup *backup =
+        sqlite3_backup_init(target, "main", this->ppdb, "main");
+    if (backup == nullptr) {
+        DatabaseException error(sqlite3_errmsg(target),
+                                sqlite3_extended_errcode(target));
+        sqlite3_close_v2(target);
+        throw error;
+    }
+    int max_wait_ms = std::stoi(this->QueryPragma("busy_timeout"));
+    if (max_wait_ms <= 0) {
+        max_wait_ms = kBackupBusyWaitMs;
+    }
+    int waited_ms = 0;
+    while (true) {
+        status = sqlite3_backup_step(backup, pages_per_step);
+        if (status == SQLITE_OK) {
+            waited_ms = 0;
+        } else if ((status == SQLITE_BUSY || status == SQLITE_LOCKED) &&
+                   waited_ms < max_wait_ms) {
+            // Another connection holds a lock, give it time to finish
+            sqlite3_sleep(5);
+            waited_ms += 5;
+        } else {
+            break;
+        }
+    }
+    sqlite3_backup_finish(backup);
+    if (status != SQLITE_DONE) {
+        DatabaseException error(sqlite3_errstr(status), status);
+        sqlite3_close_v2(target);
+        throw error;
+    }
+    sqlite3_close_v2(target);
+}
+
+/**
+ * @brief Creates the contacts table if it does not exist and migrates the
+ * schema to kSchemaVersion.
+ */
+void Database::CreateSchema() {
+    this->Execute(this->table_def.c_str());
+    int version = this->GetSchemaVersion();
+    // A schema migrated past version 2 by a SQLite without FTS5 has no
+    // full-text index, which is created once FTS5 is available
+    const bool add_fts = sqlite3_compileoption_used("ENABLE_FTS5") &&
+                         !this->HasFullTextSearch();
+    if (version >= kSchemaVersion && !add_fts) {
+        return;
+    }
+    Transaction transaction(*this);
+    if (version < kSchemaVersion) {
+        this->MigrateSchema(version);
+        this->Execute(("PRAGMA user_version = " +
+                       std::to_string(kSchemaVersion)).c_str());
+    }
+    if (add_fts && !this->HasFullTextSearch()) {
+        this->CreateFullTextSearch();
+    }
+    transaction.Commit();
+}
+
+/**
+ * @brief Applies every migration step newer than `from_version`.
+ * Each step must also work on a freshly created table.
+ *
+ * @param from_version The version the schema is currently at
+ */
+void Database::MigrateSchema(int from_version) {
+    if (from_version < 1) {
+        // Indexes for the lookups by name, email and telephone. first_name
+        // has its own index for the first_name branch of GetRecords.
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_name"
+            " ON contacts (last_name, first_name)");
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_first_name"
+            " ON contacts (first_name)");
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_email ON contacts (email)");
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_telephone"
+            " ON contacts (telephone)");
+    }
+    if (from_version < 2 && sqlite3_compileoption_used("ENABLE_FTS5")) {
+        this->CreateFullTextSearch();
     }
+    if (from_version < 3) {
+        // Case- and format-insensitive keys, computed on write by
+        // BindKeys, so that lookups by name, email and telephone stay
+        // index lookups. The exact-match indexes of version 1 are replaced
+        // by indexes on the keys, except contacts_name for paging by name.
+        if (this->HasFullTextSearch()) {
+            // Only changes of the fields need reindexing, not of the keys
+            this->Execute("DROP TRIGGER IF EXISTS contacts_fts_update");
+            this->CreateFullTextTriggers();
+        }
+        this->Execute("ALTER TABLE contacts ADD COLUMN first_name_key TEXT");
+        this->Execute("ALTER TABLE contacts ADD COLUMN last_name_key TEXT");
+        this->Execute("ALTER TABLE contacts ADD COLUMN email_key TEXT");
+        this->Execute("ALTER TABLE contacts ADD COLUMN telephone_key TEXT");
+        const int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC;
+        sqlite3_create_function(this->ppdb, "fold_name", 1, flags, nullptr,
+                                FoldFunction<FoldName>, nullptr, nullptr);
+        sqlite3_create_function(this->ppdb, "fold_email", 1, flags, nullptr,
+                                FoldFunction<FoldEmail>, nullptr, nullptr);
+        sqlite3_create_function(this->ppdb, "telephone_digits", 1, flags,
+                                nullptr, FoldFunction<TelephoneDigits>,
+                                nullptr, nullptr);
+        this->Execute(
+            "UPDATE contacts SET first_name_key = fold_name(first_name),"
+            " last_name_key = fold_name(last_name),"
+            " email_key = fold_email(email),"
+            " telephone_key = telephone_digits(telephone)");
+        this->Execute("DROP INDEX IF EXISTS contacts_first_name");
+        this->Execute("DROP INDEX IF EXISTS contacts_email");
+        this->Execute("DROP INDEX IF EXISTS contacts_telephone");
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_name_key"
+            " ON contacts (last_name_key, first_name_key)");
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_first_name_key"
+            " ON contacts (first_name_key)");
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_email_key"
+            " ON contacts (email_key)");
+        this->Execute(
+            "CREATE INDEX IF NOT EXISTS contacts_telephone_key"
+            " ON contacts (telephone_key)");
+    }
+    if (from_version < 4) {
+        // Append-only change feed read by ChangesSince. Like the full-text
+        // index, it outlives a dropped contacts table, but the triggers
+        // filling it do not.
+        this->Execute(
+            "CREATE TABLE IF NOT EXISTS contacts_changes ("
+            " sequence INTEGER PRIMARY KEY AUTOINCREMENT,"
+            " operation TEXT NOT NULL,"
+            " record_id INTEGER,"
+            " first_name TEXT,"
+            " last_name TEXT,"
+            " email TEXT,"
+            " telephone TEXT)");
+        this->Execute(
+            "CREATE TRIGGER IF NOT EXISTS contacts_changes_insert"
+            " AFTER INSERT ON contacts BEGIN"
+            "  INSERT INTO contacts_changes (operation, record_id,"
+            "   first_name, last_name, email, telephone)"
+            "  VALUES ('insert', new.rowid, new.first_name, new.last_name,"
+            "   new.email, new.telephone);"
+            " END");
+        this->Execute(
+            "CREATE TRIGGER IF NOT EXISTS contacts_changes_update"
+            " AFTER UPDATE OF first_name, last_name, email, telephone"
+            " ON contacts BEGIN"
+            "  INSERT INTO contacts_changes (operation, record_id,"
+            "   first_name, last_name, email, telephone)"
+            "  VALUES ('update', new.rowid, new.first_name, new.last_name,"
+            "   new.email, new.telephone);"
+            " END");
+        this->Execute(
+            "CREATE TRIGGER IF NOT EXISTS contacts_changes_delete"
+            " AFTER DELETE ON contacts BEGIN"
+            "  INSERT INTO contacts_changes (operation, record_id)"
+            "  VALUES ('delete', old.rowid);"
+            " END");
+    }
+    if (from_version < 5 && this->compressed) {
+        // The full-text index has to see the packed fields as text. The
+        // change feed keeps them packed, ChangesSince unpacks them like
+        // any other row. A compressed database is created at this
+        // version, so nothing is reindexed.
+        if (this->HasFullTextSearch()) {
+            this->Execute("DROP TRIGGER IF EXISTS contacts_fts_insert");
+            this->Execute("DROP TRIGGER IF EXISTS contacts_fts_delete");
+            this->Execute("DROP TRIGGER IF EXISTS contacts_fts_update");
+            this->CreateFullTextTriggers();
+        }
+    }
+}
+
+/**
+ * @brief Creates the full-text index over contacts used by Search and its
+ * triggers, and fills it from the table. The index outlives a dropped
+ * contacts table, so it is emptied first.
+ */
+void Database::CreateFullTextSearch() {
+    this->Execute(
+        "CREATE VIRTUAL TABLE IF NOT EXISTS contacts_fts USING fts5("
+        " first_name, last_name, email, telephone,"
+        " content = 'contacts', content_rowid = 'rowid',"
+        " prefix = '2 3')");
+    this->CreateFullTextTriggers();
+    if (!this->compressed) {
+        this->Execute(
+            "INSERT INTO contacts_fts (contacts_fts) VALUES ('rebuild')");
+        return;
+    }
+    // 'rebuild' would index the packed fields
+    this->Execute(
+        "INSERT INTO contacts_fts (contacts_fts) VALUES ('delete-all')");
+    this->Execute(
+        "INSERT INTO contacts_fts"
+        " (rowid, first_name, last_name, email, telephone)"
+        " SELECT rowid, first_name, last_name, unpack_email(email),"
+        " unpack_telephone(telephone) FROM contacts");
+}
+
+/**
+ * @brief Creates the triggers keeping the full-text index in sync with
+ * contacts, unless they exist. Those of a compressed database index the
+ * unpacked email and telephone.
+ */
+void Database::CreateFullTextTriggers() {
+    auto values = [this](const std::string &row) {
+        return row + ".rowid, " + row + ".first_name, " + row +
+               ".last_name, " +
+               (this->compressed ? "unpack_email(" + row + ".email), " +
+                                       "unpack_telephone(" + row +
+                                       ".telephone)"
+                                 : row + ".email, " + row + ".telephone");
+    };
+    this->Execute(
+        ("CREATE TRIGGER IF NOT EXISTS contacts_fts_insert"
+         " AFTER INSERT ON contacts BEGIN"
+         "  INSERT INTO contacts_fts"
+         "   (rowid, first_name, last_name, email, telephone)"
+         "  VALUES (" + values("new") + ");"
+         " END").c_str());
+    this->Execute(
+        ("CREATE TRIGGER IF NOT EXISTS contacts_fts_delete"
+         " AFTER DELETE ON contacts BEGIN"
+         "  INSERT INTO contacts_fts"
+         "   (contacts_fts, rowid, first_name, last_name, email, telephone)"
+         "  VALUES ('delete', " + values("old") + ");"
+         " END").c_str());
+    this->Execute(
+        ("CREATE TRIGGER IF NOT EXISTS contacts_fts_update"
+         " AFTER UPDATE OF first_name, last_name, email, telephone"
+         " ON contacts BEGIN"
+         "  INSERT INTO contacts_fts"
+         "   (contacts_fts, rowid, first_name, last_name, email, telephone)"
+         "  VALUES ('delete', " + values("old") + ");"
+         "  INSERT INTO contacts_fts"
+         "   (rowid, first_name, last_name, email, telephone)"
+         "  VALUES (" + values("new") + ");"
+         " END").c_str());
+}
+
+/**
+ * @brief Reads the value of a pragma that returns one value.
+ *
+ * @param pragma The name of the pragma
+ * @return std::string The value, empty if the pragma returns nothing
+ */
+std::string Database::QueryPragma(const char *pragma) const {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(this->ppdb, (std::string("PRAGMA ") + pragma).c_str(),
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                sqlite3_extended_errcode(this->ppdb));
+    }
+    std::string value;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *text =
+            reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        value = text == nullptr ? "" : text;
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+/**
+ * @return int The schema version stored in the user_version pragma
+ */
+int Database::GetSchemaVersion() const {
+    return std::stoi(this->QueryPragma("user_version"));
+}
+
+/**
+ * @return int The number of open transactions, 0 outside of any
+ */
+int Database::TransactionDepth() const {
+    return this->transaction_depth;
+}
+
+/**
+ * @brief Opens a transaction, or a savepoint if one is already open.
+ *
+ * @param db The database
+ * @throws DatabaseException If the transaction cannot be opened, or if
+ * SQLite already rolled back the enclosing transaction, in which case a
+ * savepoint would open a transaction of its own and commit on release
+ */
+Database::Transaction::Transaction(Database &db)
+    : db(db), depth(db.transaction_depth + 1) {
+    if (db.transaction_depth > 0 && sqlite3_get_autocommit(db.ppdb)) {
+        throw DatabaseException(
+            "The enclosing transaction was rolled back by SQLite.");
+    }
+    db.Execute(("SAVEPOINT transaction_" + std::to_string(this->depth)).c_str());
+    db.transaction_depth++;
+}
+
+/**
+ * @brief Rolls the transaction back if it was not committed.
+ */
+Database::Transaction::~Transaction() {
+    if (this->open) {
+        try {
+            this->Rollback();
+        } catch (const DatabaseException &) {
+            // SQLite already rolled back, e.g. after SQLITE_FULL
+        }
+    }
+}
+
+/**
+ * @brief Commits the transaction. Committing a savepoint merges its changes
+ * into the enclosing transaction.
+ *
+ * @throws DatabaseException If the transaction is not the innermost open
+ * one or the commit fails
+ */
+void Database::Transaction::Commit() {
+    this->CheckInnermost();
+    this->db.Execute(
+        ("RELEASE transaction_" + std::to_string(this->depth)).c_str());
+    this->open = false;
+    this->db.transaction_depth--;
+}
+
+/**
+ * @brief Rolls back the changes made since the transaction was opened.
+ * The record cache and the cached email domains are cleared, since they
+ * may hold rows read or added inside the transaction.
+ *
+ * @throws DatabaseException If the transaction is not the innermost open
+ * one or the rollback fails
+ */
+void Database::Transaction::Rollback() {
+    this->CheckInnermost();
+    this->open = false;
+    this->db.transaction_depth--;
+    if (this->db.cache) {
+        this->db.cache->Clear();
+    }
+    // Email domains added in the transaction are gone, and their ids may
+    // be given to other domains
+    this->db.domain_ids.clear();
+    this->db.domain_names.clear();
+    const std::string name = "transaction_" + std::to_string(this->depth);
+    if (sqlite3_get_autocommit(this->db.ppdb)) {
+        // SQLite has already rolled the whole transaction back
+        return;
+    }
+    this->db.Execute(("ROLLBACK TO " + name + "; RELEASE " + name).c_str());
+}
+
+/**
+ * @return bool Whether the transaction is open, i.e. neither committed,
+ * rolled back, nor rolled back by SQLite after an error such as
+ * SQLITE_FULL
+ */
+bool Database::Transaction::Active() const {
+    return this->open && !sqlite3_get_autocommit(this->db.ppdb);
+}
+
+void Database::Transaction::CheckInnermost() const {
+    if (!this->open) {
+        throw DatabaseException("The transaction is already closed.");
+    }
+    if (this->depth != this->db.transaction_depth) {
+        throw DatabaseException(
+            "An inner transaction is still open.");
+    }
+}
+
+/**
+ * @brief Executes a statement that takes no parameters and returns no rows.
+ *
+ * @param sql The SQL to execute
+ * @throws DatabaseException If the statement fails
+ */
+void Database::Execute(const char *sql) {
+    int status = sqlite3_exec(this->ppdb, sql, nullptr, nullptr, nullptr);
+    if (status != SQLITE_OK) {
+        throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                sqlite3_extended_errcode(this->ppdb));
+    }
+}
+
+/**
+ * @brief Calls `step` until it returns false, committing every
+ * `batch_size` calls in one transaction. If `step` throws, the open batch
+ * is rolled back and the exception is rethrown. Inside an enclosing
+ * transaction, the batches are savepoints that commit with it.
+ *
+ * @param step Applies one operation and sets its argument to the number
+ * of rows it affected, returns false when there are no more operations
+ * @param batch_size The number of operations per transaction, at least 1
+ * @return std::vector<int> The number of rows affected by each batch
+ */
+std::vector<int> Database::RunInBatches(const std::function<bool(int &)> &step,
+                                        std::size_t batch_size) {
+    if (batch_size == 0) {
+        batch_size = 1;
+    }
+    std::vector<int> batches;
+    std::size_t in_batch = 0;
+    std::optional<Transaction> transaction;
+    int changes = 0;
+    while (true) {
+        if (!transaction) {
+            transaction.emplace(*this);
+            batches.push_back(0);
+        }
+        if (!step(changes)) {
+            break;
+        }
+        batches.back() += changes;
+        if (++in_batch == batch_size) {
+            transaction->Commit();
+            transaction.reset();
+            in_batch = 0;
+        }
+    }
+    transaction->Commit();
+    if (in_batch == 0) {
+        // The last transaction was opened for nothing
+        batches.pop_back();
+    }
+    return batches;
+}
+
+/**
+ * @brief Returns the cached statement for `key`, preparing it from `sql`
+ * on first use. The statement stays prepared until the database is closed;
+ * callers reset it after use with a StatementReset.
+ *
+ * @param key The operation the statement belongs to
+ * @param sql The SQL of the statement, only read on first use
+ * @return sqlite3_stmt* The prepared statement
+ * @throws DatabaseException If the statement cannot be prepared
+ */
+sqlite3_stmt *Database::PrepareCached(Statement key, const char *sql) const {
+    const std::size_t index = static_cast<std::size_t>(key);
+    sqlite3_stmt *&stmt = this->statements[index];
+    if (stmt == nullptr) {
+#ifdef ADDRESS_BOOK_METRICS
+        auto start = MetricsRecorder::Clock::now();
+#endif
+        int status = sqlite3_prepare_v3(this->ppdb, sql, -1,
+                                        SQLITE_PREPARE_PERSISTENT, &stmt,
+                                        nullptr);
+        if (status != SQLITE_OK) {
+            stmt = nullptr;
+            throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                    sqlite3_extended_errcode(this->ppdb));
+        }
+#ifdef ADDRESS_BOOK_METRICS
+        if (this->metrics) {
+            this->metrics->Prepared(index, start);
+        }
+#endif
+    }
+#ifdef ADDRESS_BOOK_METRICS
+    if (this->metrics) {
+        this->metrics->HandedOut(index);
+    }
+#endif
+    return stmt;
+}
+
+/**
+ * @brief Finalizes all cached statements.
+ */
+void Database::FinalizeStatements() {
+    for (auto &stmt : this->statements) {
+        sqlite3_finalize(stmt);
+        stmt = nullptr;
+    }
+}
+
+/**
+ * @brief Steps a cached statement, recording the step when metrics are
+ * enabled.
+ *
+ * @param key The key the statement was prepared with by PrepareCached
+ * @return int The result of sqlite3_step
+ */
+int Database::Step(Statement key) const {
+    const std::size_t index = static_cast<std::size_t>(key);
+    sqlite3_stmt *stmt = this->statements[index];
+#ifdef ADDRESS_BOOK_METRICS
+    if (this->metrics) {
+        auto start = MetricsRecorder::Clock::now();
+        int status = sqlite3_step(stmt);
+        std::uint64_t bytes = 0;
+        if (status == SQLITE_ROW) {
+            // Only the text fields, reading the rowid as bytes would convert it
+            for (int i = 0; i < 4 && i < sqlite3_column_count(stmt); i++) {
+                bytes += sqlite3_column_bytes(stmt, i);
+            }
+        }
+        this->metrics->Stepped(index, start, status == SQLITE_ROW, bytes);
+        return status;
+    }
+#endif
+    return sqlite3_step(stmt);
+}
+
+/**
+ * @brief Steps a data-modifying statement to completion.
+ *
+ * @param key The key of a bound cached statement that returns no rows
+ * @return int The number of rows affected
+ * @throws DatabaseException If the statement fails
+ */
+int Database::StepAndCountChanges(Statement key) const {
+    int status = this->Step(key);
+    if (status != SQLITE_DONE) {
+        throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                sqlite3_extended_errcode(this->ppdb));
+    }
+    return sqlite3_changes(this->ppdb);
 }
 
 /**
  * @brief Get a record fron a row in the query result.
- * The function expects a full row in the table. If the result
- * is not a full row or nothing can be retrieved from the column,
- * the result is undefined.
+ * The function expects the columns first_name, last_name, email,
+ * telephone and ROWID in order. If the result is not such a row or
+ * nothing can be retrieved from the column, the result is undefined.
  * @param stmt The statement object after `step`
  * @return A record
  */
 Record Database::GetRecordFromRow(sqlite3_stmt* stmt) const {
-    Record record;
-    record.first_name =
-        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-    record.last_name =
-        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-    record.email = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-    record.telephone =
-        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-    return record;
+    UnpackedFields unpacked;
+    return this->GetViewFromRow(stmt, unpacked).ToRecord();
 }
 
 /**
- * @brief The callback function (helper) of Database::GetAllRecords
+ * @brief Get a view of a row in the query result, with the same column
+ * layout as GetRecordFromRow. Packed fields are unpacked into `unpacked`.
+ * The view is valid until the statement is stepped or reset, or
+ * `unpacked` is changed.
+ * @param stmt The statement object after `step`
+ * @param unpacked Holds the fields that were stored packed
+ * @return A record view
+ */
+RecordView Database::GetViewFromRow(sqlite3_stmt *stmt,
+                                    UnpackedFields &unpacked) const {
+    auto column = [stmt](int i) {
+        // Text first, then bytes, as the SQLite docs recommend
+        const char *text =
+            reinterpret_cast<const char *>(sqlite3_column_text(stmt, i));
+        return text == nullptr
+                   ? std::string_view()
+                   : std::string_view(text, sqlite3_column_bytes(stmt, i));
+    };
+    auto blob = [stmt](int i) {
+        return std::string_view(
+            static_cast<const char *>(sqlite3_column_blob(stmt, i)),
+            static_cast<std::size_t>(sqlite3_column_bytes(stmt, i)));
+    };
+    RecordView view;
+    view.first_name = column(0);
+    view.last_name = column(1);
+    // Only the fields of a compressed database can be blobs
+    if (sqlite3_column_type(stmt, 2) == SQLITE_BLOB) {
+        this->UnpackEmailField(blob(2), unpacked.email);
+        view.email = unpacked.email;
+    } else {
+        view.email = column(2);
+    }
+    if (sqlite3_column_type(stmt, 3) == SQLITE_BLOB) {
+        if (!UnpackTelephone(blob(3), unpacked.telephone)) {
+            throw DatabaseException("Corrupt packed telephone.");
+        }
+        view.telephone = unpacked.telephone;
+    } else {
+        view.telephone = column(3);
+    }
+    view.id = sqlite3_column_int(stmt, 4);
+    return view;
+}
+
+/**
+ * @brief Unpacks an email stored packed by BindStatement.
  *
- * @param arg A pointer to a vector of records
- * @param colc Number of columns, i.e. the number of strings in colv
- * @param colv The array of strings of values
- * @param col_name The name of the columns
- * @return int Always 0
- */
-int Database::GetAllRecordsCallback(void* arg,
-                                    int colc,
-                                    char** colv,
-                                    char** col_name) {
-    std::vector<Record>* pvec = reinterpret_cast<std::vector<Record>*>(arg);
-    Record record;
-    record.first_name = colv[0];
-    record.last_name = colv[1];
-    record.email = colv[2];
-    record.telephone = colv[3];
-    record.id = std::stoi(colv[4]);
-    pvec->push_back(record);
-    return 0;
+ * @param packed The packed email
+ * @param email Set to the email
+ * @throws DatabaseException If `packed` is corrupt
+ */
+void Database::UnpackEmailField(std::string_view packed,
+                                std::string &email) const {
+    std::int64_t domain_id;
+    std::string_view local;
+    if (!UnpackEmail(packed, domain_id, local)) {
+        throw DatabaseException("Corrupt packed email.");
+    }
+    const std::string &domain = this->DomainName(domain_id);
+    email.clear();
+    email.reserve(local.size() + 1 + domain.size());
+    email.append(local);
+    email.push_back('@');
+    email.append(domain);
+}
+
+/**
+ * @brief Returns the id of an email domain in contacts_email_domains.
+ *
+ * @param domain The domain, i.e. the part of an email after the `@`
+ * @param add Whether to add the domain if it is not in the table
+ * @return std::int64_t The id of the domain, 0 if it is not in the table
+ * and `add` is false
+ */
+std::int64_t Database::FindDomain(std::string_view domain, bool add) const {
+    auto it = this->domain_ids.find(std::string(domain));
+    if (it != this->domain_ids.end()) {
+        return it->second;
+    }
+    std::int64_t id = 0;
+    {
+        sqlite3_stmt *find = this->PrepareCached(
+            Statement::FindDomain,
+            "SELECT id FROM contacts_email_domains WHERE domain = ?");
+        StatementReset reset(find);
+        sqlite3_bind_text(find, 1, domain.data(),
+                          static_cast<int>(domain.size()), SQLITE_STATIC);
+        int status = this->Step(Statement::FindDomain);
+        if (status == SQLITE_ROW) {
+            id = sqlite3_column_int64(find, 0);
+        } else if (status != SQLITE_DONE) {
+            throw DatabaseException(sqlite3_errmsg(this->ppdb),
+                                    sqlite3_extended_errcode(this->ppdb));
+        }
+    }
+    if (id == 0) {
+        if (!add) {
+            return 0;
+        }
+        sqlite3_stmt *insert = this->PrepareCached(
+            Statement::AddDomain,
+            "INSERT INTO contacts_email_domains (domain) VALUES (?)");
+        StatementReset reset(insert);
+        sqlite3_bind_text(insert, 1, domain.data(),
+                          static_cast<int>(domain.size()), SQLITE_STATIC);
+        this->StepAndCountChanges(Statement::AddDomain);
+        id = sqlite3_last_insert_rowid(this->ppdb);
+    }
+    this->domain_ids.emplace(domain, id);
+    this->domain_names.emplace(id, domain);
+    return id;
+}
+
+/**
+ * @brief Returns the email domain with id `id` in contacts_email_domains.
+ *
+ * @throws DatabaseException If there is no such domain
+ */
+const std::string &Database::DomainName(std::int64_t id) const {
+    auto it = this->domain_names.find(id);
+    if (it != this->domain_names.end()) {
+        return it->second;
+    }
+    sqlite3_stmt *stmt = this->PrepareCached(
+        Statement::GetDomain,
+        "SELECT domain FROM contacts_email_domains WHERE id = ?");
+    StatementReset reset(stmt);
+    sqlite3_bind_int64(stmt, 1, id);
+    if (this->Step(Statement::GetDomain) != SQLITE_ROW) {
+        throw DatabaseException("Unknown email domain " + std::to_string(id) +
+                                ".");
+    }
+    std::string domain = reinterpret_cast<const char *>(
+        sqlite3_column_text(stmt, 0));
+    this->domain_ids.emplace(domain, id);
+    return this->domain_names.emplace(id, std::move(domain)).first->second;
 }
 
 /**
- * @brief Binds the values in record to statement in order.
+ * @brief Steps a bound query and passes every row to `visitor`.
+ *
+ * @param key The key of a bound cached query with the columns expected by
+ * GetViewFromRow
+ * @param visitor Called for every row, returns false to stop
+ * @return std::size_t The number of rows visited
+ */
+std::size_t Database::ScanStatement(Statement key,
+                                    const RecordVisitor &visitor) const {
+    sqlite3_stmt *stmt = this->statements[static_cast<std::size_t>(key)];
+    std::size_t count = 0;
+    int status;
+    UnpackedFields unpacked;
+    while ((status = this->Step(key)) == SQLITE_ROW) {
+        count++;
+        if (!visitor(this->GetViewFromRow(stmt, unpacked))) {
+            return count;
+        }
+    }
+    if (status != SQLITE_DONE) {
+        sqlite3 *db = sqlite3_db_handle(stmt);
+        throw DatabaseException(sqlite3_errmsg(db),
+                                sqlite3_extended_errcode(db));
+    }
+    return count;
+}
+
+/**
+ * @brief Binds the values in record to statement in order. In a
+ * compressed database, the email and telephone are bound packed when they
+ * fit the forms of Packing.hpp, so that every value is always stored the
+ * same way and compares equal to itself.
  * 
  * @param record 
  * @param stmt A prepared statement with exactly 4 arguments to bind
+ * @param add_domains Whether to add the email domain to
+ * contacts_email_domains if it is missing. Without it, the email is bound
+ * as text, which then matches no stored email.
  * @return sqlite3_stmt* The statement object
  */
-sqlite3_stmt *Database::BindStatement(const Record &record, sqlite3_stmt *stmt) {
+sqlite3_stmt *Database::BindStatement(const Record &record, sqlite3_stmt *stmt,
+                                      bool add_domains) const {
     sqlite3_bind_text(stmt, 1, record.first_name.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, record.last_name.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, record.email.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, record.telephone.c_str(), -1, SQLITE_STATIC);
+    std::string packed;
+    std::string_view local;
+    std::string_view domain;
+    std::int64_t domain_id = 0;
+    if (this->compressed && SplitEmail(record.email, local, domain) &&
+        (domain_id = this->FindDomain(domain, add_domains)) != 0) {
+        PackEmail(domain_id, local, packed);
+        sqlite3_bind_blob(stmt, 3, packed.data(),
+                          static_cast<int>(packed.size()), SQLITE_TRANSIENT);
+    } else {
+        sqlite3_bind_text(stmt, 3, record.email.c_str(), -1, SQLITE_STATIC);
+    }
+    if (this->compressed && PackTelephone(record.telephone, packed)) {
+        sqlite3_bind_blob(stmt, 4, packed.data(),
+                          static_cast<int>(packed.size()), SQLITE_TRANSIENT);
+    } else {
+        sqlite3_bind_text(stmt, 4, record.telephone.c_str(), -1,
+                          SQLITE_STATIC);
+    }
     return stmt;
 }
 
+/**
+ * @brief Binds the lookup keys of the fields of record, i.e. the folded
+ * names, folded email and telephone digits, in order.
+ *
+ * @param record
+ * @param stmt A prepared statement with 4 arguments to bind from
+ * `first_index` on
+ * @param first_index The index of the first_name key
+ * @return sqlite3_stmt* The statement object
+ */
+sqlite3_stmt *Database::BindKeys(const Record &record, sqlite3_stmt *stmt,
+                                 int first_index) {
+    const std::string keys[] = {
+        FoldName(record.first_name), FoldName(record.last_name),
+        FoldEmail(record.email), TelephoneDigits(record.telephone)};
+    for (int i = 0; i < 4; i++) {
+        sqlite3_bind_text(stmt, first_index + i, keys[i].c_str(),
+                          static_cast<int>(keys[i].size()), SQLITE_TRANSIENT);
+    }
+    return stmt;
+}
 
 sqlite3_stmt *Database::BindStatementText(sqlite3_stmt *stmt, std::initializer_list<std::string>  params) {
     int i = 1;
@@ -278,11 +1715,11 @@ sqlite3_stmt *Database::BindStatementText(sqlite3_stmt *stmt, std::initializer_l
         sqlite3_bind_text(stmt, i, param.c_str(), -1, SQLITE_TRANSIENT);
         i++;
     }
-    std::string s(sqlite3_expanded_sql(stmt));
     return stmt;
 }
 
 Database::~Database() {
+    this->FinalizeStatements();
     sqlite3_close_v2(this->ppdb);
 }
 
@@ -1,10 +1,14 @@
 #include "DatabaseException.hpp"
 
 namespace AddressBook {
-    DatabaseException::DatabaseException(const std::string msg) {
+    DatabaseException::DatabaseException(const std::string msg, int code) {
         this->msg = msg;
+        this->error_code = code;
     }
     const char *DatabaseException::what() const noexcept {
         return this->msg.c_str();
     }
+    int DatabaseException::code() const noexcept {
+        return this->error_code;
+    }
 }
@@ -0,0 +1,62 @@
+#include "DatabaseOptions.hpp"
+#include "DatabaseException.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Returns the options of a named preset:
+ * - `default`: SQLite's defaults, i.e. rollback journal and synchronous=FULL
+ * - `durable`: WAL with synchronous=FULL, no committed write is ever lost
+ * - `fast`: WAL with synchronous=NORMAL, a 64 MiB page cache, 256 MiB of
+ *   mmap and in-memory temporary tables. A power loss may roll back the
+ *   last commits, but never corrupts the database.
+ *
+ * @param preset The name of the preset
+ * @return DatabaseOptions The options of the preset
+ * @throws DatabaseException If the preset does not exist
+ */
+DatabaseOptions DatabaseOptions::FromPreset(const std::string &preset) {
+    DatabaseOptions options;
+    if (preset == "default") {
+        return options;
+    }
+    options.journal_mode = "wal";
+    if (preset == "durable") {
+        options.synchronous = "full";
+    } else if (preset == "fast") {
+        options.synchronous = "normal";
+        options.cache_size = -64 * 1024;
+        options.mmap_size = 256 * 1024 * 1024;
+        options.temp_store = "memory";
+    } else {
+        throw DatabaseException("Unknown preset \"" + preset + "\".");
+    }
+    return options;
+}
+
+/**
+ * @brief Prints the options, one `name: value` line each. Settings that
+ * are left to SQLite are printed as "default".
+ *
+ * @param os Output stream
+ * @param options The options to be printed
+ * @return std::ostream& The output stream
+ */
+std::ostream &operator<<(std::ostream &os, const DatabaseOptions &options) {
+    auto text = [](const std::string &value) {
+        return value.empty() ? std::string("default") : value;
+    };
+    auto number = [](const auto &value) {
+        return value ? std::to_string(*value) : std::string("default");
+    };
+    os << "read_only: " << (options.read_only ? "true" : "false") << '\n';
+    os << "busy_timeout_ms: " << options.busy_timeout_ms << '\n';
+    os << "journal_mode: " << text(options.journal_mode) << '\n';
+    os << "synchronous: " << text(options.synchronous) << '\n';
+    os << "cache_size: " << number(options.cache_size) << '\n';
+    os << "mmap_size: " << number(options.mmap_size) << '\n';
+    os << "temp_store: " << text(options.temp_store) << '\n';
+    os << "page_size: " << number(options.page_size) << '\n';
+    os << "compressed: " << (options.compressed ? "true" : "false") << '\n';
+    return os;
+}
+}  // namespace AddressBook
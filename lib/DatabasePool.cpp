@@ -0,0 +1,107 @@
+#include "DatabasePool.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Construct a new DatabasePool object. Opens the writer first,
+ * which creates the schema and switches the file to WAL mode, then the
+ * read-only connections.
+ *
+ * @param uri The uri to an on-disk database
+ * @param readers The number of read connections, at least 1
+ * @param options The settings of every connection. journal_mode and
+ * read_only are set by the pool, page_size only applies to the writer.
+ * @param retry How Read and Write retry busy operations
+ */
+DatabasePool::DatabasePool(const std::string &uri, std::size_t readers,
+                           const DatabaseOptions &options,
+                           const RetryPolicy &retry)
+    : retry(retry) {
+    DatabaseOptions writer_options(options);
+    writer_options.read_only = false;
+    writer_options.journal_mode = "wal";
+    this->writer = std::make_unique<Database>(uri, writer_options);
+    DatabaseOptions reader_options(options);
+    reader_options.read_only = true;
+    reader_options.journal_mode.clear();
+    reader_options.page_size.reset();
+    for (std::size_t i = 0; i < std::max<std::size_t>(readers, 1); i++) {
+        this->readers.push_back(
+            std::make_unique<Database>(uri, reader_options));
+        this->idle_readers.push_back(this->readers.back().get());
+    }
+}
+
+/**
+ * @brief Waits for an idle read connection and leases it.
+ */
+DatabasePool::Lease DatabasePool::AcquireReader() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->available.wait(lock, [this]() { return !this->idle_readers.empty(); });
+    Database *db = this->idle_readers.back();
+    this->idle_readers.pop_back();
+    return Lease(this, db);
+}
+
+/**
+ * @brief Waits for the write connection and leases it.
+ */
+DatabasePool::Lease DatabasePool::AcquireWriter() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->available.wait(lock, [this]() { return this->writer_idle; });
+    this->writer_idle = false;
+    return Lease(this, this->writer.get());
+}
+
+/**
+ * @return std::size_t The number of read connections
+ */
+std::size_t DatabasePool::ReaderCount() const {
+    return this->readers.size();
+}
+
+bool DatabasePool::IsBusy(const DatabaseException &e) {
+    int primary = e.code() & 0xff;
+    return primary == SQLITE_BUSY || primary == SQLITE_LOCKED;
+}
+
+void DatabasePool::Return(Database *db) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (db == this->writer.get()) {
+            this->writer_idle = true;
+        } else {
+            this->idle_readers.push_back(db);
+        }
+    }
+    this->available.notify_all();
+}
+
+DatabasePool::Lease::Lease(DatabasePool *pool, Database *db)
+    : pool(pool), db(db) {}
+
+DatabasePool::Lease::Lease(Lease &&other) noexcept
+    : pool(other.pool), db(other.db) {
+    other.db = nullptr;
+}
+
+DatabasePool::Lease &DatabasePool::Lease::operator=(Lease &&other) noexcept {
+    if (this != &other) {
+        this->Release();
+        this->pool = other.pool;
+        this->db = other.db;
+        other.db = nullptr;
+    }
+    return *this;
+}
+
+DatabasePool::Lease::~Lease() {
+    this->Release();
+}
+
+void DatabasePool::Lease::Release() {
+    if (this->db != nullptr) {
+        this->pool->Return(this->db);
+        this->db = nullptr;
+    }
+}
+}  // namespace AddressBook
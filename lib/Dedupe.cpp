@@ -0,0 +1,310 @@
+#include "Dedupe.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include "Normalize.hpp"
+
+namespace AddressBook {
+namespace {
+/**
+ * @brief The normalized fields a record is compared by
+ */
+struct MatchKeys {
+    std::string name;  // Letters and digits of the folded full name
+    std::string email;
+    std::string telephone;
+};
+
+MatchKeys KeysOf(const RecordView &record) {
+    MatchKeys keys;
+    std::string name = FoldName(record.first_name);
+    name += FoldName(record.last_name);
+    for (char c : name) {
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            keys.name.push_back(c);
+        }
+    }
+    keys.email = FoldEmail(record.email);
+    keys.telephone = TelephoneDigits(record.telephone);
+    return keys;
+}
+
+/**
+ * @brief Levenshtein distance with Myers' bit-parallel algorithm: one
+ * machine word holds a column of the DP matrix, so each character of `text`
+ * costs a handful of word operations instead of a pass over `pattern`.
+ *
+ * @param pattern At most 64 bytes
+ */
+std::size_t BitParallelDistance(std::string_view pattern,
+                                std::string_view text) {
+    // Bit i of peq[c] is set where pattern[i] == c. Kept zeroed between
+    // calls, so only the bits of the pattern are set and cleared.
+    thread_local std::array<std::uint64_t, 256> peq{};
+    for (std::size_t i = 0; i < pattern.size(); i++) {
+        peq[static_cast<unsigned char>(pattern[i])] |= std::uint64_t(1) << i;
+    }
+    const std::uint64_t last = std::uint64_t(1) << (pattern.size() - 1);
+    std::uint64_t pv = ~std::uint64_t(0);
+    std::uint64_t mv = 0;
+    std::size_t score = pattern.size();
+    for (char c : text) {
+        std::uint64_t eq = peq[static_cast<unsigned char>(c)];
+        std::uint64_t xv = eq | mv;
+        std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t ph = mv | ~(xh | pv);
+        std::uint64_t mh = pv & xh;
+        if (ph & last) {
+            score++;
+        } else if (mh & last) {
+            score--;
+        }
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    for (char c : pattern) {
+        peq[static_cast<unsigned char>(c)] = 0;
+    }
+    return score;
+}
+
+/**
+ * @brief Levenshtein distance with the two-row dynamic program, for
+ * strings too long for BitParallelDistance.
+ */
+std::size_t RowDistance(std::string_view a, std::string_view b) {
+    std::vector<std::size_t> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); j++) {
+        row[j] = j;
+    }
+    for (std::size_t i = 1; i <= a.size(); i++) {
+        std::size_t diagonal = row[0];
+        row[0] = i;
+        for (std::size_t j = 1; j <= b.size(); j++) {
+            std::size_t above = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1,
+                               diagonal + (a[i - 1] != b[j - 1])});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+/**
+ * @brief The weighted similarity of the fields both records have. Names
+ * count twice as much as email and telephone.
+ */
+double ScoreKeys(const MatchKeys &a, const MatchKeys &b) {
+    const std::pair<const std::string *, const std::string *> fields[] = {
+        {&a.name, &b.name},
+        {&a.email, &b.email},
+        {&a.telephone, &b.telephone}};
+    const double weights[] = {2, 1, 1};
+    double score = 0;
+    double weight = 0;
+    for (int i = 0; i < 3; i++) {
+        if (fields[i].first->empty() || fields[i].second->empty()) {
+            continue;
+        }
+        score += weights[i] * Similarity(*fields[i].first, *fields[i].second);
+        weight += weights[i];
+    }
+    return weight > 0 ? score / weight : 0;
+}
+
+/**
+ * @brief A record in a block, sorted by block key then by name so that
+ * similar names are next to each other
+ */
+struct BlockEntry {
+    std::string key;
+    std::uint32_t index;
+};
+
+/**
+ * @brief A pair of records scoring at least the threshold, by index
+ */
+struct Match {
+    std::uint32_t first;
+    std::uint32_t second;
+    double score;
+};
+
+/**
+ * @brief Scores the pairs of records sharing a block key and at most
+ * `window` positions apart in their block, splitting the blocks between
+ * `threads` threads.
+ */
+void ScoreBlocks(std::vector<BlockEntry> &entries,
+                 const std::vector<MatchKeys> &keys,
+                 const DedupeOptions &options, std::size_t threads,
+                 std::vector<Match> &matches) {
+    std::sort(entries.begin(), entries.end(),
+              [&](const BlockEntry &a, const BlockEntry &b) {
+                  if (a.key != b.key) {
+                      return a.key < b.key;
+                  }
+                  return keys[a.index].name < keys[b.index].name;
+              });
+    std::vector<std::vector<Match>> found(threads);
+    auto score = [&](std::size_t thread) {
+        std::size_t begin = entries.size() * thread / threads;
+        std::size_t end = entries.size() * (thread + 1) / threads;
+        for (std::size_t i = begin; i < end; i++) {
+            for (std::size_t j = i + 1;
+                 j < entries.size() && j <= i + options.window &&
+                 entries[j].key == entries[i].key;
+                 j++) {
+                std::uint32_t a = entries[i].index;
+                std::uint32_t b = entries[j].index;
+                double value = ScoreKeys(keys[a], keys[b]);
+                if (value >= options.threshold) {
+                    found[thread].push_back(
+                        {std::min(a, b), std::max(a, b), value});
+                }
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < threads; t++) {
+        workers.emplace_back(score, t);
+    }
+    score(0);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (const auto &thread_matches : found) {
+        matches.insert(matches.end(), thread_matches.begin(),
+                       thread_matches.end());
+    }
+}
+}  // namespace
+
+/**
+ * @return std::size_t The Levenshtein distance between `a` and `b`
+ */
+std::size_t EditDistance(std::string_view a, std::string_view b) {
+    if (a.size() > b.size()) {
+        std::swap(a, b);
+    }
+    if (a.empty()) {
+        return b.size();
+    }
+    return a.size() <= 64 ? BitParallelDistance(a, b) : RowDistance(a, b);
+}
+
+/**
+ * @return double 1 minus the edit distance relative to the longer string:
+ * 1 for equal strings, 0 for completely different ones
+ */
+double Similarity(std::string_view a, std::string_view b) {
+    std::size_t longest = std::max(a.size(), b.size());
+    if (longest == 0) {
+        return 1;
+    }
+    return 1 - static_cast<double>(EditDistance(a, b)) / longest;
+}
+
+/**
+ * @brief How likely two records describe the same contact, comparing their
+ * case-folded names, emails and telephone digits.
+ *
+ * @return double From 0 to 1
+ */
+double MatchScore(const RecordView &a, const RecordView &b) {
+    return ScoreKeys(KeysOf(a), KeysOf(b));
+}
+
+/**
+ * @brief Finds pairs of records that likely describe the same contact.
+ * Records are grouped into blocks by the Soundex code of their last name,
+ * their email domain and their telephone digits. Within a block, records
+ * sorted by name are compared to the `window` records following them, so
+ * the work grows linearly with the number of records rather than with its
+ * square. The blocks are scored in parallel.
+ *
+ * @param records The records to search
+ * @param options The threshold, window and number of threads
+ * @return std::vector<DuplicatePair> The pairs scoring at least the
+ * threshold, best first
+ */
+std::vector<DuplicatePair> FindDuplicates(const RecordBatch &records,
+                                          const DedupeOptions &options) {
+    std::vector<MatchKeys> keys;
+    keys.reserve(records.Size());
+    for (const RecordView &record : records) {
+        keys.push_back(KeysOf(record));
+    }
+    std::size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<std::size_t>(1, std::min(threads, keys.size() / 1024));
+    std::vector<Match> matches;
+    std::vector<BlockEntry> entries;
+    entries.reserve(records.Size());
+    for (int kind = 0; kind < 3; kind++) {
+        entries.clear();
+        for (std::uint32_t i = 0; i < records.Size(); i++) {
+            std::string key;
+            if (kind == 0) {
+                key = Soundex(records[i].last_name);
+            } else if (kind == 1) {
+                std::size_t at = keys[i].email.rfind('@');
+                if (at != std::string::npos) {
+                    key = keys[i].email.substr(at + 1);
+                }
+            } else {
+                key = keys[i].telephone;
+            }
+            if (!key.empty()) {
+                entries.push_back({std::move(key), i});
+            }
+        }
+        ScoreBlocks(entries, keys, options, threads, matches);
+    }
+    // A pair sharing several keys is found once per key
+    std::sort(matches.begin(), matches.end(),
+              [](const Match &a, const Match &b) {
+                  return std::make_pair(a.first, a.second) <
+                         std::make_pair(b.first, b.second);
+              });
+    matches.erase(std::unique(matches.begin(), matches.end(),
+                              [](const Match &a, const Match &b) {
+                                  return a.first == b.first &&
+                                         a.second == b.second;
+                              }),
+                  matches.end());
+
+    std::vector<DuplicatePair> duplicates;
+    duplicates.reserve(matches.size());
+    for (const Match &match : matches) {
+        DuplicatePair duplicate;
+        duplicate.first = records[match.first].ToRecord();
+        duplicate.second = records[match.second].ToRecord();
+        duplicate.score = match.score;
+        duplicates.push_back(std::move(duplicate));
+    }
+    std::stable_sort(duplicates.begin(), duplicates.end(),
+                     [](const DuplicatePair &a, const DuplicatePair &b) {
+                         return a.score > b.score;
+                     });
+    return duplicates;
+}
+
+/**
+ * @brief Finds pairs of records of the database that likely describe the
+ * same contact, see FindDuplicates(const RecordBatch &, const DedupeOptions &).
+ */
+std::vector<DuplicatePair> FindDuplicates(const Database &db,
+                                          const DedupeOptions &options) {
+    RecordBatch records;
+    db.GetAllRecords(records);
+    return FindDuplicates(records, options);
+}
+}  // namespace AddressBook
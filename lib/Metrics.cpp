@@ -0,0 +1,186 @@
+#include "Metrics.hpp"
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+namespace AddressBook {
+namespace {
+std::uint64_t NanosecondsSince(MetricsRecorder::Clock::time_point start) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            MetricsRecorder::Clock::now() - start)
+            .count());
+}
+
+/**
+ * @return The bucket of `value`: two bits for the position of its highest
+ * bit, and two for the bits below it
+ */
+std::size_t BucketOf(std::uint64_t value) {
+    if (value < 4) {
+        return static_cast<std::size_t>(value);
+    }
+    int high = 63;
+    while (!(value >> high)) {
+        high--;
+    }
+    return static_cast<std::size_t>(4 * (high - 1) + ((value >> (high - 2)) & 3));
+}
+
+/**
+ * @return The largest value in `bucket`
+ */
+std::uint64_t BucketLimit(std::size_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    int high = static_cast<int>(bucket / 4) + 1;
+    std::uint64_t base = (std::uint64_t(1) << high) |
+                         (std::uint64_t(bucket % 4) << (high - 2));
+    return base + (std::uint64_t(1) << (high - 2)) - 1;
+}
+
+nlohmann::json HistogramJson(const LatencyHistogram &histogram) {
+    return {{"count", histogram.Count()},
+            {"total_ns", histogram.TotalNanoseconds()},
+            {"p50_ns", histogram.Percentile(50)},
+            {"p99_ns", histogram.Percentile(99)},
+            {"max_ns", histogram.MaxNanoseconds()}};
+}
+
+void PrintHistogram(std::ostream &os, const char *name,
+                    const LatencyHistogram &histogram) {
+    if (histogram.Count() == 0) {
+        return;
+    }
+    os << "  " << name << ": " << histogram.Count() << " x, p50 "
+       << histogram.Percentile(50) << " ns, p99 " << histogram.Percentile(99)
+       << " ns, max " << histogram.MaxNanoseconds() << " ns" << '\n';
+}
+}  // namespace
+
+void LatencyHistogram::Add(std::uint64_t nanoseconds) {
+    this->buckets[BucketOf(nanoseconds)]++;
+    this->count++;
+    this->total += nanoseconds;
+    if (nanoseconds > this->max) {
+        this->max = nanoseconds;
+    }
+}
+
+std::uint64_t LatencyHistogram::Count() const { return this->count; }
+
+std::uint64_t LatencyHistogram::TotalNanoseconds() const { return this->total; }
+
+std::uint64_t LatencyHistogram::MaxNanoseconds() const { return this->max; }
+
+/**
+ * @param percent Between 0 and 100
+ * @return std::uint64_t The upper bound of the bucket holding the
+ * percentile, at most the largest value added; 0 if the histogram is empty
+ */
+std::uint64_t LatencyHistogram::Percentile(double percent) const {
+    std::uint64_t rank = static_cast<std::uint64_t>(percent / 100 * this->count);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; i++) {
+        seen += this->buckets[i];
+        if (seen > rank) {
+            return std::min(BucketLimit(i), this->max);
+        }
+    }
+    return this->max;
+}
+
+/**
+ * @return std::string The report as a JSON object
+ */
+std::string MetricsReport::ToJson() const {
+    nlohmann::json statements = nlohmann::json::object();
+    for (const auto &[name, metrics] : this->statements) {
+        statements[name] = {{"prepares", metrics.prepares},
+                            {"executions", metrics.executions},
+                            {"rows", metrics.rows},
+                            {"bytes", metrics.bytes},
+                            {"prepare", HistogramJson(metrics.prepare)},
+                            {"bind", HistogramJson(metrics.bind)},
+                            {"step", HistogramJson(metrics.step)}};
+    }
+    nlohmann::json sqlite = {
+        {"cache_hits", this->sqlite.cache_hits},
+        {"cache_misses", this->sqlite.cache_misses},
+        {"cache_writes", this->sqlite.cache_writes},
+        {"cache_used_bytes", this->sqlite.cache_used_bytes},
+        {"schema_used_bytes", this->sqlite.schema_used_bytes},
+        {"statement_used_bytes", this->sqlite.statement_used_bytes}};
+    return nlohmann::json{{"statements", statements}, {"sqlite", sqlite}}
+        .dump(2);
+}
+
+std::ostream &operator<<(std::ostream &os, const MetricsReport &report) {
+    for (const auto &[name, metrics] : report.statements) {
+        os << name << ": " << metrics.executions << " executions, "
+           << metrics.rows << " rows, " << metrics.bytes << " bytes" << '\n';
+        PrintHistogram(os, "prepare", metrics.prepare);
+        PrintHistogram(os, "bind", metrics.bind);
+        PrintHistogram(os, "step", metrics.step);
+    }
+    os << "Page cache: " << report.sqlite.cache_hits << " hits, "
+       << report.sqlite.cache_misses << " misses, "
+       << report.sqlite.cache_writes << " writes, "
+       << report.sqlite.cache_used_bytes << " bytes" << '\n'
+       << "Schema memory: " << report.sqlite.schema_used_bytes << " bytes"
+       << '\n'
+       << "Statement memory: " << report.sqlite.statement_used_bytes
+       << " bytes" << '\n';
+    return os;
+}
+
+MetricsRecorder::MetricsRecorder(std::size_t statements)
+    : statements(statements), handed_out(statements), bound(statements) {}
+
+/**
+ * @brief Records a prepare of `statement` that started at `start`.
+ */
+void MetricsRecorder::Prepared(std::size_t statement,
+                               Clock::time_point start) {
+    this->statements[statement].prepares++;
+    this->statements[statement].prepare.Add(NanosecondsSince(start));
+}
+
+/**
+ * @brief Marks `statement` as handed out to be bound and executed.
+ */
+void MetricsRecorder::HandedOut(std::size_t statement) {
+    this->handed_out[statement] = Clock::now();
+    this->bound[statement] = false;
+}
+
+/**
+ * @brief Records a step of `statement` that started at `start`. The first
+ * step after the statement was handed out counts as an execution.
+ *
+ * @param row Whether the step returned a row
+ * @param bytes The size of the fields of the row
+ */
+void MetricsRecorder::Stepped(std::size_t statement, Clock::time_point start,
+                              bool row, std::uint64_t bytes) {
+    StatementMetrics &metrics = this->statements[statement];
+    if (!this->bound[statement]) {
+        this->bound[statement] = true;
+        metrics.executions++;
+        metrics.bind.Add(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                start - this->handed_out[statement])
+                .count()));
+    }
+    metrics.step.Add(NanosecondsSince(start));
+    if (row) {
+        metrics.rows++;
+        metrics.bytes += bytes;
+    }
+}
+
+const StatementMetrics &MetricsRecorder::operator[](
+    std::size_t statement) const {
+    return this->statements[statement];
+}
+}  // namespace AddressBook
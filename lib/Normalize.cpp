@@ -0,0 +1,102 @@
+#include "Normalize.hpp"
+
+namespace AddressBook {
+namespace {
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+           c == '\v';
+}
+
+char Lower(char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+}  // namespace
+
+/**
+ * @brief Lowercases a name, trims it and collapses runs of whitespace into
+ * one space, e.g. ` Peter  O' PARKER` into `peter o' parker`.
+ */
+std::string FoldName(std::string_view name) {
+    std::string folded;
+    folded.reserve(name.size());
+    bool space = false;
+    for (char c : name) {
+        if (IsSpace(c)) {
+            space = !folded.empty();
+            continue;
+        }
+        if (space) {
+            folded.push_back(' ');
+            space = false;
+        }
+        folded.push_back(Lower(c));
+    }
+    return folded;
+}
+
+/**
+ * @brief Lowercases and trims an email address.
+ */
+std::string FoldEmail(std::string_view email) {
+    while (!email.empty() && IsSpace(email.front())) {
+        email.remove_prefix(1);
+    }
+    while (!email.empty() && IsSpace(email.back())) {
+        email.remove_suffix(1);
+    }
+    std::string folded(email);
+    for (char &c : folded) {
+        c = Lower(c);
+    }
+    return folded;
+}
+
+/**
+ * @brief Keeps the digits of a telephone number, and a leading `+` of an
+ * international number, e.g. `+852 9384-6572` into `+85293846572`.
+ */
+std::string TelephoneDigits(std::string_view telephone) {
+    std::string digits;
+    digits.reserve(telephone.size());
+    for (char c : telephone) {
+        if (c >= '0' && c <= '9') {
+            digits.push_back(c);
+        } else if (c == '+' && digits.empty()) {
+            digits = "+";
+        }
+    }
+    return digits == "+" ? std::string() : digits;
+}
+
+/**
+ * @brief The American Soundex code of the letters of a name, e.g. `R163`
+ * for both Robert and Rupert, or an empty string if it has no letters.
+ */
+std::string Soundex(std::string_view name) {
+    // The digit of every letter from a to z, 0 for vowels and h, w, y
+    static const char codes[] = "01230120022455012623010202";
+    std::string code;
+    char last = 0;
+    for (char c : name) {
+        c = Lower(c);
+        if (c < 'a' || c > 'z') {
+            continue;
+        }
+        char digit = codes[c - 'a'];
+        if (code.empty()) {
+            code.push_back(c - 'a' + 'A');
+        } else if (digit != '0' && digit != last) {
+            code.push_back(digit);
+            if (code.size() == 4) {
+                return code;
+            }
+        }
+        // h and w do not separate letters with the same code
+        if (c != 'h' && c != 'w') {
+            last = digit;
+        }
+    }
+    if (!code.empty()) {
+        code.resize(4, '0');
+    }
+    return code;
+}
+}  // namespace AddressBook
@@ -0,0 +1,120 @@
+#include "Packing.hpp"
+
+namespace AddressBook {
+namespace {
+// The characters of a packed telephone, indexed by their 4-bit code. The
+// last code pads a telephone of odd length.
+const char kTelephoneCodes[] = "0123456789+ -()";
+const unsigned char kPadding = 0xf;
+
+int TelephoneCode(char c) {
+    for (int code = 0; code < 0xf; code++) {
+        if (kTelephoneCodes[code] == c) {
+            return code;
+        }
+    }
+    return -1;
+}
+}  // namespace
+
+/**
+ * @brief Packs a telephone two characters per byte, e.g. `+1 555-0100`
+ * into 6 bytes.
+ *
+ * @param telephone The telephone
+ * @param packed Set to the packed telephone
+ * @return bool False if the telephone is empty or has other characters
+ * than digits, spaces and `+-()`
+ */
+bool PackTelephone(std::string_view telephone, std::string &packed) {
+    if (telephone.empty()) {
+        return false;
+    }
+    packed.clear();
+    for (std::size_t i = 0; i < telephone.size(); i += 2) {
+        int high = TelephoneCode(telephone[i]);
+        int low = i + 1 < telephone.size() ? TelephoneCode(telephone[i + 1])
+                                           : kPadding;
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        packed.push_back(static_cast<char>(high << 4 | low));
+    }
+    return true;
+}
+
+/**
+ * @brief Reverses PackTelephone.
+ *
+ * @return bool False if `packed` is not a packed telephone
+ */
+bool UnpackTelephone(std::string_view packed, std::string &telephone) {
+    telephone.clear();
+    for (std::size_t i = 0; i < packed.size(); i++) {
+        unsigned char byte = static_cast<unsigned char>(packed[i]);
+        unsigned char high = byte >> 4;
+        unsigned char low = byte & 0xf;
+        if (high == kPadding ||
+            (low == kPadding && i + 1 != packed.size())) {
+            return false;
+        }
+        telephone.push_back(kTelephoneCodes[high]);
+        if (low != kPadding) {
+            telephone.push_back(kTelephoneCodes[low]);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Splits an email at its last `@`.
+ *
+ * @return bool False if the email has no `@` or nothing after it
+ */
+bool SplitEmail(std::string_view email, std::string_view &local,
+                std::string_view &domain) {
+    std::size_t at = email.rfind('@');
+    if (at == std::string_view::npos || at + 1 == email.size()) {
+        return false;
+    }
+    local = email.substr(0, at);
+    domain = email.substr(at + 1);
+    return true;
+}
+
+/**
+ * @brief Packs the id of an email domain as a varint, followed by the part
+ * of the email before the `@`.
+ */
+void PackEmail(std::int64_t domain_id, std::string_view local,
+               std::string &packed) {
+    packed.clear();
+    std::uint64_t value = static_cast<std::uint64_t>(domain_id);
+    while (value >= 0x80) {
+        packed.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    packed.push_back(static_cast<char>(value));
+    packed.append(local);
+}
+
+/**
+ * @brief Reverses PackEmail. `local` points into `packed`.
+ *
+ * @return bool False if `packed` is not a packed email
+ */
+bool UnpackEmail(std::string_view packed, std::int64_t &domain_id,
+                 std::string_view &local) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < packed.size() && i < 10; i++) {
+        unsigned char byte = static_cast<unsigned char>(packed[i]);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            domain_id = static_cast<std::int64_t>(value);
+            local = packed.substr(i + 1);
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace AddressBook
@@ -8,12 +8,23 @@ namespace AddressBook {
      * @param record The record to be printed
      * @return std::ostream& The output stream
      */
-    std::ostream& operator<<(std::ostream& os, Record record) {
+    std::ostream& operator<<(std::ostream& os, const Record &record) {
+        return os << RecordView(record);
+    }
+
+    /**
+     * @brief Prints the record view to the output stream
+     * 
+     * @param os Output stream
+     * @param record The record to be printed
+     * @return std::ostream& The output stream
+     */
+    std::ostream& operator<<(std::ostream& os, const RecordView &record) {
         os << "#" << record.id << ":\n";
         os << "First name: " << record.first_name << "\n";
         os << "Last name: " << record.last_name << "\n";
         os << "Email: " << record.email << "\n";
-        os << "Telephone: " << record.telephone << std::endl;
+        os << "Telephone: " << record.telephone << '\n';
         return os;
     }
 
@@ -29,4 +40,27 @@ namespace AddressBook {
         this->email = params.at(2);
         this->telephone = params.at(3);
     }
-}
\ No newline at end of file
+
+    /**
+     * @brief Construct a view of `record`, valid while `record` is alive
+     */
+    RecordView::RecordView(const Record &record)
+        : id(record.id),
+          first_name(record.first_name),
+          last_name(record.last_name),
+          email(record.email),
+          telephone(record.telephone) {}
+
+    /**
+     * @brief Copies the viewed fields into an owning record
+     */
+    Record RecordView::ToRecord() const {
+        Record record;
+        record.id = this->id;
+        record.first_name = this->first_name;
+        record.last_name = this->last_name;
+        record.email = this->email;
+        record.telephone = this->telephone;
+        return record;
+    }
+}
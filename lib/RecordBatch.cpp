@@ -0,0 +1,88 @@
+#include "RecordBatch.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Reserves room for `rows` rows with `arena_bytes` bytes of fields
+ * in total.
+ */
+void RecordBatch::Reserve(std::size_t rows, std::size_t arena_bytes) {
+    this->rows.reserve(rows);
+    this->arena.reserve(arena_bytes);
+}
+
+/**
+ * @brief Copies a record to the end of the batch.
+ *
+ * @param record The record, which may point into any memory
+ */
+void RecordBatch::Append(const RecordView &record) {
+    Row row;
+    row.id = record.id;
+    row.offset = this->arena.size();
+    const std::string_view fields[] = {record.first_name, record.last_name,
+                                       record.email, record.telephone};
+    for (int i = 0; i < 4; i++) {
+        row.lengths[i] = static_cast<std::uint32_t>(fields[i].size());
+        this->arena.append(fields[i]);
+    }
+    this->rows.push_back(row);
+}
+
+/**
+ * @brief Removes all rows, keeping the memory for the next fill.
+ */
+void RecordBatch::Clear() {
+    this->rows.clear();
+    this->arena.clear();
+}
+
+/**
+ * @return std::size_t The number of rows
+ */
+std::size_t RecordBatch::Size() const {
+    return this->rows.size();
+}
+
+/**
+ * @return bool Whether the batch has no rows
+ */
+bool RecordBatch::Empty() const {
+    return this->rows.empty();
+}
+
+/**
+ * @brief Returns a view of the `i`-th row, valid until the batch is
+ * modified
+ */
+RecordView RecordBatch::operator[](std::size_t i) const {
+    const Row &row = this->rows[i];
+    const char *data = this->arena.data() + row.offset;
+    RecordView view;
+    view.id = row.id;
+    view.first_name = std::string_view(data, row.lengths[0]);
+    data += row.lengths[0];
+    view.last_name = std::string_view(data, row.lengths[1]);
+    data += row.lengths[1];
+    view.email = std::string_view(data, row.lengths[2]);
+    data += row.lengths[2];
+    view.telephone = std::string_view(data, row.lengths[3]);
+    return view;
+}
+
+RecordBatch::Iterator RecordBatch::begin() const {
+    return Iterator(this, 0);
+}
+
+RecordBatch::Iterator RecordBatch::end() const {
+    return Iterator(this, this->rows.size());
+}
+
+/**
+ * @return std::size_t The memory held by the batch, including unused
+ * capacity
+ */
+std::size_t RecordBatch::MemoryBytes() const {
+    return sizeof(RecordBatch) + this->rows.capacity() * sizeof(Row) +
+           this->arena.capacity();
+}
+}  // namespace AddressBook
@@ -0,0 +1,131 @@
+#include "RecordCache.hpp"
+#include "Normalize.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Construct a new RecordCache object
+ *
+ * @param byte_budget The maximum estimated size of the cached records
+ */
+RecordCache::RecordCache(std::size_t byte_budget) {
+    this->stats.byte_budget = byte_budget;
+}
+
+/**
+ * @brief Looks up the record cached for a name and marks it as recently
+ * used. Counts a hit or a miss.
+ *
+ * @param first_name The first name
+ * @param last_name The last name
+ * @param record Set to the cached record on a hit
+ * @return bool Whether the name is cached
+ */
+bool RecordCache::FindByName(const std::string &first_name,
+                             const std::string &last_name, Record &record) {
+    auto name = this->by_name.find(RecordCache::NameKey(first_name, last_name));
+    if (name == this->by_name.end()) {
+        this->stats.misses++;
+        return false;
+    }
+    auto entry = this->by_id.at(name->second);
+    this->entries.splice(this->entries.begin(), this->entries, entry);
+    record = entry->record;
+    this->stats.hits++;
+    return true;
+}
+
+/**
+ * @brief Caches a record read from the database as the record of its name,
+ * evicting least recently used records to stay within the budget.
+ *
+ * @param record A record with a valid id
+ */
+void RecordCache::Insert(const Record &record) {
+    std::size_t size = RecordCache::EntrySize(record);
+    if (size > this->stats.byte_budget) {
+        return;
+    }
+    this->EraseId(record.id);
+    this->EraseName(record.first_name, record.last_name);
+    while (this->stats.bytes + size > this->stats.byte_budget) {
+        this->Erase(std::prev(this->entries.end()));
+        this->stats.evictions++;
+    }
+    this->entries.push_front({record, size});
+    this->by_id[record.id] = this->entries.begin();
+    this->by_name[RecordCache::NameKey(record.first_name, record.last_name)] =
+        record.id;
+    this->stats.bytes += size;
+    this->stats.entries++;
+}
+
+/**
+ * @brief Drops the record with `rowid`, if cached
+ */
+void RecordCache::EraseId(int rowid) {
+    auto id = this->by_id.find(rowid);
+    if (id != this->by_id.end()) {
+        this->Erase(id->second);
+    }
+}
+
+/**
+ * @brief Drops the record cached for a name, if any
+ */
+void RecordCache::EraseName(const std::string &first_name,
+                            const std::string &last_name) {
+    auto name = this->by_name.find(RecordCache::NameKey(first_name, last_name));
+    if (name != this->by_name.end()) {
+        this->Erase(this->by_id.at(name->second));
+    }
+}
+
+/**
+ * @brief Drops all records. The hit and miss counters are kept.
+ */
+void RecordCache::Clear() {
+    this->entries.clear();
+    this->by_id.clear();
+    this->by_name.clear();
+    this->stats.bytes = 0;
+    this->stats.entries = 0;
+}
+
+/**
+ * @return CacheStats The counters of the cache
+ */
+CacheStats RecordCache::Stats() const {
+    return this->stats;
+}
+
+std::string RecordCache::NameKey(const std::string &first_name,
+                                 const std::string &last_name) {
+    // Folded like the keys GetRecordByName looks up
+    std::string key = FoldName(first_name);
+    key += '\0';
+    key += FoldName(last_name);
+    return key;
+}
+
+/**
+ * @brief Estimates the memory held by a cached record: the record, its
+ * strings, the name key and the list and map nodes.
+ */
+std::size_t RecordCache::EntrySize(const Record &record) {
+    return sizeof(Record) + record.first_name.capacity() +
+           record.last_name.capacity() + record.email.capacity() +
+           record.telephone.capacity() + sizeof(std::string) +
+           2 * (record.first_name.size() + record.last_name.size() + 1) +
+           8 * sizeof(void *);
+}
+
+void RecordCache::Erase(Entries::iterator entry) {
+    const Record &record = entry->record;
+    this->stats.bytes -= entry->size;
+    this->stats.entries--;
+    this->by_name.erase(
+        RecordCache::NameKey(record.first_name, record.last_name));
+    this->by_id.erase(record.id);
+    this->entries.erase(entry);
+}
+}  // namespace AddressBook
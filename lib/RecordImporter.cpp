@@ -0,0 +1,250 @@
+#include "RecordImporter.hpp"
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include "ShardedDatabase.hpp"
+
+namespace AddressBook {
+namespace {
+const char *const kCsvHeader = "first_name,last_name,email,telephone";
+// The header of the CSV written by RecordWriter, whose ids are ignored
+const char *const kCsvHeaderWithId = "id,first_name,last_name,email,telephone";
+
+/**
+ * @brief Splits a CSV row into fields. Fields may be quoted with `"`,
+ * and `""` inside a quoted field stands for one quote.
+ *
+ * @param line The row
+ * @param fields The fields of the row
+ * @return bool False if a quoted field is not terminated
+ */
+bool SplitCsv(const std::string &line, std::vector<std::string> &fields) {
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(std::move(field));
+    return !quoted;
+}
+
+/**
+ * @brief Streams the records in `input` into `db`, a Database or a
+ * ShardedDatabase, and times it
+ */
+template <typename DatabaseType>
+ImportResult Import(DatabaseType &db, std::istream &input, ImportFormat format,
+                    std::size_t batch_size) {
+    auto start = std::chrono::steady_clock::now();
+    RecordImporter importer(input, format);
+    ImportResult result;
+    result.imported = db.AddRecords(
+        [&](Record &record) { return importer.Next(record); }, batch_size);
+    result.skipped = importer.Skipped();
+    result.errors = importer.Errors();
+    result.seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    return result;
+}
+}  // namespace
+
+/**
+ * @brief Construct a new RecordImporter object
+ *
+ * @param input The stream to read rows from. Only one row is held in memory
+ * at a time.
+ * @param format The format of the rows
+ */
+RecordImporter::RecordImporter(std::istream &input, ImportFormat format)
+    : input(input), format(format) {}
+
+/**
+ * @brief Reads the next valid record, skipping rows that cannot be parsed.
+ *
+ * @param record Filled with the record read
+ * @return bool False when the stream is exhausted
+ */
+bool RecordImporter::Next(Record &record) {
+    std::string line;
+    while (this->ReadLine(line)) {
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+        bool parsed = this->format == ImportFormat::Csv
+                          ? this->ParseCsv(line, record)
+                          : this->ParseJsonLine(line, record);
+        if (parsed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return std::size_t The number of rows skipped so far
+ */
+std::size_t RecordImporter::Skipped() const {
+    return this->skipped;
+}
+
+/**
+ * @return The reasons of the first kMaxErrors skipped rows
+ */
+const std::vector<std::string> &RecordImporter::Errors() const {
+    return this->errors;
+}
+
+/**
+ * @brief Guesses the format of a file from its extension.
+ * `.jsonl` and `.ndjson` files are JSON Lines, anything else is CSV.
+ */
+ImportFormat RecordImporter::FormatFromPath(const std::string &path) {
+    for (const std::string extension : {".jsonl", ".ndjson"}) {
+        if (path.size() >= extension.size() &&
+            path.compare(path.size() - extension.size(), extension.size(),
+                         extension) == 0) {
+            return ImportFormat::JsonLines;
+        }
+    }
+    return ImportFormat::Csv;
+}
+
+/**
+ * @brief Parses a CSV row. A header on the first line is skipped; if it
+ * starts with an `id` column, as written by RecordWriter, that column is
+ * ignored in every row.
+ */
+bool RecordImporter::ParseCsv(const std::string &line, Record &record) {
+    std::string row(line);
+    std::vector<std::string> fields;
+    // A quoted field may span a few lines
+    std::vector<std::string> continuation;
+    while (!SplitCsv(row, fields)) {
+        std::string next;
+        if (continuation.size() == kMaxQuotedLines ||
+            !this->ReadLine(next)) {
+            // Only this row is bad, the lines read after it are parsed
+            // again as rows of their own
+            this->line_number -= continuation.size();
+            this->pending.insert(this->pending.begin(), continuation.begin(),
+                                 continuation.end());
+            this->Skip("unterminated quoted field");
+            return false;
+        }
+        row += '\n';
+        row += next;
+        continuation.push_back(std::move(next));
+    }
+    if (this->line_number == 1) {
+        if (row.rfind(kCsvHeaderWithId, 0) == 0) {
+            this->leading_id = true;
+            return false;
+        }
+        if (row.rfind(kCsvHeader, 0) == 0) {
+            return false;
+        }
+    }
+    const std::size_t expected = this->leading_id ? 5 : 4;
+    if (fields.size() != expected) {
+        this->Skip("expected " + std::to_string(expected) + " fields, got " +
+                   std::to_string(fields.size()));
+        return false;
+    }
+    if (this->leading_id) {
+        // The record gets a new id in the database it is imported into
+        fields.erase(fields.begin());
+    }
+    record = Record(fields);
+    return true;
+}
+
+bool RecordImporter::ParseJsonLine(const std::string &line, Record &record) {
+    auto row = nlohmann::json::parse(line, nullptr, false);
+    if (row.is_discarded() || !row.is_object()) {
+        this->Skip("not a JSON object");
+        return false;
+    }
+    for (const char *key : {"first_name", "last_name", "email", "telephone"}) {
+        auto it = row.find(key);
+        if (it == row.end() || !it->is_string()) {
+            this->Skip(std::string("missing string field \"") + key + "\"");
+            return false;
+        }
+    }
+    record.first_name = row["first_name"].get<std::string>();
+    record.last_name = row["last_name"].get<std::string>();
+    record.email = row["email"].get<std::string>();
+    record.telephone = row["telephone"].get<std::string>();
+    return true;
+}
+
+/**
+ * @brief Reads the next line, first from the lines given back by ParseCsv
+ *
+ * @param line Set to the line read
+ * @return bool False when the stream is exhausted
+ */
+bool RecordImporter::ReadLine(std::string &line) {
+    if (!this->pending.empty()) {
+        line = std::move(this->pending.front());
+        this->pending.pop_front();
+    } else if (!std::getline(this->input, line)) {
+        return false;
+    }
+    this->line_number++;
+    return true;
+}
+
+void RecordImporter::Skip(const std::string &reason) {
+    this->skipped++;
+    if (this->errors.size() < kMaxErrors) {
+        this->errors.push_back("line " + std::to_string(this->line_number) +
+                               ": " + reason);
+    }
+}
+
+/**
+ * @brief Streams the records in `input` into the database in batched
+ * transactions. Rows that cannot be parsed are skipped without aborting
+ * the batch they belong to.
+ *
+ * @param db The database to import into
+ * @param input The stream to read rows from
+ * @param format The format of the rows
+ * @param batch_size The number of rows per transaction
+ * @return ImportResult The number of rows imported and skipped
+ */
+ImportResult ImportRecords(Database &db, std::istream &input,
+                           ImportFormat format, std::size_t batch_size) {
+    return Import(db, input, format, batch_size);
+}
+
+/**
+ * @brief Streams the records in `input` into a sharded database, every
+ * shard adding its part of each chunk in parallel.
+ *
+ * @param batch_size The number of rows per transaction of each shard
+ */
+ImportResult ImportRecords(ShardedDatabase &db, std::istream &input,
+                           ImportFormat format, std::size_t batch_size) {
+    return Import(db, input, format, batch_size);
+}
+}  // namespace AddressBook
@@ -0,0 +1,216 @@
+#include "RecordWriter.hpp"
+
+namespace AddressBook {
+namespace {
+// The minimum widths of the columns of OutputFormat::Table but the last
+const std::size_t kTableWidths[] = {8, 16, 16, 28};
+const char *const kTableHeaders[] = {"id", "first_name", "last_name", "email",
+                                     "telephone"};
+}  // namespace
+
+/**
+ * @brief Construct a new RecordWriter object. Writes the header of the
+ * format, if any.
+ *
+ * @param os The stream to write to
+ * @param format The format of the records
+ * @param buffer_size How many bytes are buffered before they are written
+ * @param flush_on_close Whether the destructor flushes the stream. If
+ * false, it only writes the buffer out and the owner of the stream
+ * flushes it, e.g. once at the end of a script.
+ */
+RecordWriter::RecordWriter(std::ostream &os, OutputFormat format,
+                           std::size_t buffer_size, bool flush_on_close)
+    : os(os),
+      format(format),
+      buffer_size(buffer_size),
+      flush_on_close(flush_on_close) {
+    this->buffer.reserve(buffer_size + 1024);
+    if (format == OutputFormat::Csv) {
+        this->buffer += "id,first_name,last_name,email,telephone\n";
+    } else if (format == OutputFormat::Table) {
+        for (int i = 0; i < 4; i++) {
+            this->AppendPadded(kTableHeaders[i], kTableWidths[i]);
+        }
+        this->buffer += kTableHeaders[4];
+        this->buffer += '\n';
+    }
+}
+
+RecordWriter::~RecordWriter() {
+    if (this->flush_on_close) {
+        this->Flush();
+    } else {
+        this->Drain();
+    }
+}
+
+/**
+ * @brief Formats a record into the buffer, writing the buffer out if it is
+ * full.
+ */
+void RecordWriter::Write(const RecordView &record) {
+    const std::string id = std::to_string(record.id);
+    const std::string_view fields[] = {record.first_name, record.last_name,
+                                       record.email, record.telephone};
+    switch (this->format) {
+        case OutputFormat::Text:
+            this->buffer += '#';
+            this->buffer += id;
+            this->buffer += ":\nFirst name: ";
+            this->buffer += record.first_name;
+            this->buffer += "\nLast name: ";
+            this->buffer += record.last_name;
+            this->buffer += "\nEmail: ";
+            this->buffer += record.email;
+            this->buffer += "\nTelephone: ";
+            this->buffer += record.telephone;
+            this->buffer += '\n';
+            this->buffer.append(30, '-');
+            this->buffer += '\n';
+            break;
+        case OutputFormat::Table:
+            this->AppendPadded(id, kTableWidths[0]);
+            for (int i = 0; i < 3; i++) {
+                this->AppendPadded(fields[i], kTableWidths[i + 1]);
+            }
+            this->buffer += record.telephone;
+            this->buffer += '\n';
+            break;
+        case OutputFormat::Csv:
+            this->buffer += id;
+            for (const auto &field : fields) {
+                this->buffer += ',';
+                this->AppendCsvField(field);
+            }
+            this->buffer += '\n';
+            break;
+        case OutputFormat::JsonLines:
+            this->buffer += "{\"id\":";
+            this->buffer += id;
+            this->buffer += ",\"first_name\":";
+            this->AppendJsonString(record.first_name);
+            this->buffer += ",\"last_name\":";
+            this->AppendJsonString(record.last_name);
+            this->buffer += ",\"email\":";
+            this->AppendJsonString(record.email);
+            this->buffer += ",\"telephone\":";
+            this->AppendJsonString(record.telephone);
+            this->buffer += "}\n";
+            break;
+    }
+    this->count++;
+    if (this->buffer.size() >= this->buffer_size) {
+        this->Drain();
+    }
+}
+
+/**
+ * @brief Writes out the buffer and flushes the stream.
+ */
+void RecordWriter::Flush() {
+    this->Drain();
+    this->os.flush();
+}
+
+/**
+ * @return std::size_t The number of records written
+ */
+std::size_t RecordWriter::Count() const {
+    return this->count;
+}
+
+/**
+ * @brief Parses the name of a format: `text`, `table`, `csv` or `jsonl`.
+ *
+ * @return bool False if the name is not a format
+ */
+bool RecordWriter::FormatFromName(const std::string &name,
+                                  OutputFormat &format) {
+    if (name == "text") {
+        format = OutputFormat::Text;
+    } else if (name == "table") {
+        format = OutputFormat::Table;
+    } else if (name == "csv") {
+        format = OutputFormat::Csv;
+    } else if (name == "jsonl") {
+        format = OutputFormat::JsonLines;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Appends a CSV field, quoted if it contains a separator, a quote or
+ * a line break, as read back by RecordImporter.
+ */
+void RecordWriter::AppendCsvField(std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        this->buffer += field;
+        return;
+    }
+    this->buffer += '"';
+    for (char c : field) {
+        if (c == '"') {
+            this->buffer += '"';
+        }
+        this->buffer += c;
+    }
+    this->buffer += '"';
+}
+
+/**
+ * @brief Appends `text` as a JSON string. Bytes above 0x7f are copied as
+ * they are, so UTF-8 text stays UTF-8.
+ */
+void RecordWriter::AppendJsonString(std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    this->buffer += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                this->buffer += "\\\"";
+                break;
+            case '\\':
+                this->buffer += "\\\\";
+                break;
+            case '\n':
+                this->buffer += "\\n";
+                break;
+            case '\r':
+                this->buffer += "\\r";
+                break;
+            case '\t':
+                this->buffer += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    this->buffer += "\\u00";
+                    this->buffer += hex[(c >> 4) & 0xf];
+                    this->buffer += hex[c & 0xf];
+                } else {
+                    this->buffer += c;
+                }
+        }
+    }
+    this->buffer += '"';
+}
+
+/**
+ * @brief Appends `text` padded with spaces to `width`, and a space.
+ */
+void RecordWriter::AppendPadded(std::string_view text, std::size_t width) {
+    this->buffer += text;
+    if (text.size() < width) {
+        this->buffer.append(width - text.size(), ' ');
+    }
+    this->buffer += ' ';
+}
+
+void RecordWriter::Drain() {
+    this->os.write(this->buffer.data(),
+                   static_cast<std::streamsize>(this->buffer.size()));
+    this->buffer.clear();
+}
+}  // namespace AddressBook
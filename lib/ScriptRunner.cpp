@@ -0,0 +1,318 @@
+#include "ScriptRunner.hpp"
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include "DatabaseException.hpp"
+#include "RecordImporter.hpp"
+#include "RecordWriter.hpp"
+
+namespace AddressBook {
+namespace {
+// The maximum number of records printed by the search command
+const int kSearchLimit = 20;
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool ParseInteger(const std::string &text, long long &value) {
+    try {
+        std::size_t end;
+        value = std::stoll(text, &end);
+        return end == text.size();
+    } catch (const std::logic_error &) {
+        return false;
+    }
+}
+
+bool ParseId(const std::string &text, int &id) {
+    long long value;
+    if (!ParseInteger(text, value) || value < 0 || value > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    id = static_cast<int>(value);
+    return true;
+}
+
+/**
+ * @brief Runs the commands of a script, one line at a time. A command that
+ * cannot be run is explained in `reason` and changes nothing.
+ */
+class Script {
+   public:
+    Script(Database &db, std::ostream &output, ScriptResult &result)
+        : db(db), output(output), result(result) {}
+    bool Run(const std::vector<std::string> &words, std::string &reason);
+
+   private:
+    // The writers of get, list and search leave flushing the output to
+    // RunScript, which flushes it once at the end
+    bool ParseFormat(const std::vector<std::string> &words, std::size_t at,
+                     OutputFormat &format, std::string &reason);
+    Database &db;
+    std::ostream &output;
+    ScriptResult &result;
+};
+
+/**
+ * @brief Parses the optional `--format name` at `words[at]`.
+ */
+bool Script::ParseFormat(const std::vector<std::string> &words,
+                         std::size_t at, OutputFormat &format,
+                         std::string &reason) {
+    format = OutputFormat::Text;
+    if (words.size() == at) {
+        return true;
+    }
+    if (words.size() != at + 2 || words[at] != "--format") {
+        reason = "expected --format and a format after " + words[0];
+        return false;
+    }
+    if (!RecordWriter::FormatFromName(words[at + 1], format)) {
+        reason = "unknown format \"" + words[at + 1] + "\"";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Runs one command, given as its name followed by its arguments
+ * as the interactive menu takes them.
+ *
+ * @return bool False if the command is unknown or its arguments are
+ * invalid
+ * @throws DatabaseException If the command fails in the database
+ */
+bool Script::Run(const std::vector<std::string> &words, std::string &reason) {
+    const std::string &name = words[0];
+    const std::size_t count = words.size() - 1;
+    auto fields = [&](std::size_t first) {
+        return Record(std::vector<std::string>(words.begin() + first,
+                                               words.begin() + first + 4));
+    };
+    int id;
+    if (name == "add" && count == 4) {
+        this->db.AddRecord(fields(1));
+        this->result.rows++;
+    } else if (name == "update" && count == 5) {
+        if (!ParseId(words[1], id)) {
+            reason = "\"" + words[1] + "\" is not a record id";
+            return false;
+        }
+        this->result.rows += this->db.UpdateRecord(id, fields(2));
+    } else if (name == "delete" && count == 1) {
+        if (!ParseId(words[1], id)) {
+            reason = "\"" + words[1] + "\" is not a record id";
+            return false;
+        }
+        this->result.rows += this->db.DeleteRecord(id);
+    } else if (name == "delete_many" && count >= 1) {
+        std::vector<int> ids;
+        for (std::size_t i = 1; i < words.size(); i++) {
+            if (!ParseId(words[i], id)) {
+                reason = "\"" + words[i] + "\" is not a record id";
+                return false;
+            }
+            ids.push_back(id);
+        }
+        for (int rowid : ids) {
+            this->result.rows += this->db.DeleteRecord(rowid);
+        }
+    } else if (name == "delete_by_name" && count == 2) {
+        this->result.rows += this->db.DeleteRecord(words[1], words[2]);
+    } else if (name == "delete_by_details" && count == 4) {
+        this->result.rows += this->db.DeleteRecord(fields(1));
+    } else if (name == "get" && (count == 2 || count == 4)) {
+        OutputFormat format;
+        if (!this->ParseFormat(words, 3, format, reason)) {
+            return false;
+        }
+        Record record = this->db.GetRecordByName(words[1], words[2]);
+        if (record.id != -1) {
+            RecordWriter(this->output, format, RecordWriter::kDefaultBufferSize,
+                         false)
+                .Write(record);
+        }
+    } else if (name == "list" && (count == 0 || count == 2)) {
+        OutputFormat format;
+        if (!this->ParseFormat(words, 1, format, reason)) {
+            return false;
+        }
+        RecordWriter writer(this->output, format,
+                            RecordWriter::kDefaultBufferSize, false);
+        this->db.Scan([&](const RecordView &record) {
+            writer.Write(record);
+            return true;
+        });
+    } else if (name == "search" && count >= 1) {
+        std::string query;
+        for (std::size_t i = 1; i < words.size(); i++) {
+            query += words[i] + ' ';
+        }
+        RecordWriter writer(this->output, OutputFormat::Text,
+                            RecordWriter::kDefaultBufferSize, false);
+        for (const auto &record : this->db.Search(query, kSearchLimit)) {
+            writer.Write(record);
+        }
+    } else if (name == "import" && (count == 1 || count == 2)) {
+        long long batch_size = Database::kDefaultBatchSize;
+        if (count == 2 && (!ParseInteger(words[2], batch_size) ||
+                           batch_size <= 0)) {
+            reason = "the batch size must be a positive number";
+            return false;
+        }
+        std::ifstream file(words[1]);
+        if (!file.is_open()) {
+            reason = "cannot open \"" + words[1] + "\"";
+            return false;
+        }
+        this->result.rows +=
+            ImportRecords(this->db, file, RecordImporter::FormatFromPath(words[1]),
+                          static_cast<std::size_t>(batch_size))
+                .imported;
+    } else if (name == "clear" && count == 1) {
+        if (words[1] != "yes" && words[1] != "YES") {
+            reason = "clear needs \"yes\" to confirm";
+            return false;
+        }
+        this->db.ClearRecords();
+    } else if (name == "compact_changes" && count == 1) {
+        long long sequence;
+        if (!ParseInteger(words[1], sequence)) {
+            reason = "\"" + words[1] + "\" is not a sequence";
+            return false;
+        }
+        this->db.CompactChanges(sequence);
+    } else {
+        reason = "unknown command or wrong number of arguments: " + name;
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+/**
+ * @brief Splits a command line into words at whitespace. A word may be
+ * quoted with `"` or `'` to contain whitespace, and `\` escapes the next
+ * character inside quotes.
+ *
+ * @param line The command line
+ * @param words Set to the words
+ * @return bool False if a quote is not closed
+ */
+bool SplitCommand(const std::string &line, std::vector<std::string> &words) {
+    words.clear();
+    std::size_t i = 0;
+    while (true) {
+        while (i < line.size() && IsSpace(line[i])) {
+            i++;
+        }
+        if (i == line.size()) {
+            return true;
+        }
+        std::string word;
+        while (i < line.size() && !IsSpace(line[i])) {
+            char quote = line[i];
+            if (quote != '"' && quote != '\'') {
+                word += line[i++];
+                continue;
+            }
+            i++;
+            while (i < line.size() && line[i] != quote) {
+                if (line[i] == '\\' && i + 1 < line.size()) {
+                    i++;
+                }
+                word += line[i++];
+            }
+            if (i == line.size()) {
+                return false;
+            }
+            i++;
+        }
+        words.push_back(std::move(word));
+    }
+}
+
+/**
+ * @brief Runs the commands of a script without the interactive menu, one
+ * command per line. Blank lines and lines starting with `#` are ignored.
+ * The commands take the arguments of the menu commands of the same names:
+ * add, update, delete, delete_many, delete_by_name, delete_by_details,
+ * get, list, search, import, clear and compact_changes. get and list
+ * also take `--format name`; get prints nothing for a missing record.
+ * Every `batch_size` commands share one transaction, so a script of many
+ * small writes costs a few commits, and the statements stay prepared
+ * across commands. Lines that are not valid commands are skipped. A
+ * command failing in the database stops the script: the commands since
+ * the last commit are rolled back, the batches committed before stay.
+ *
+ * @param db The database
+ * @param script The stream to read commands from
+ * @param output The stream the records read by get, list and search are
+ * written to, without flushing after every command
+ * @param batch_size The number of commands per transaction
+ * @return ScriptResult What the script did
+ */
+ScriptResult RunScript(Database &db, std::istream &script, std::ostream &output,
+                       std::size_t batch_size) {
+    auto start = std::chrono::steady_clock::now();
+    if (batch_size == 0) {
+        batch_size = 1;
+    }
+    ScriptResult result;
+    Script runner(db, output, result);
+    std::optional<Database::Transaction> transaction;
+    std::size_t in_batch = 0;
+    std::size_t line_number = 0;
+    std::string line;
+    std::vector<std::string> words;
+    std::string reason;
+    auto skip = [&](const std::string &why) {
+        result.skipped++;
+        if (result.errors.size() < kMaxScriptErrors) {
+            result.errors.push_back("line " + std::to_string(line_number) +
+                                    ": " + why);
+        }
+    };
+    try {
+        while (std::getline(script, line)) {
+            line_number++;
+            if (!SplitCommand(line, words)) {
+                skip("unclosed quote");
+                continue;
+            }
+            if (words.empty() || words[0][0] == '#') {
+                continue;
+            }
+            if (!transaction) {
+                transaction.emplace(db);
+            }
+            if (!runner.Run(words, reason)) {
+                skip(reason);
+                continue;
+            }
+            result.commands++;
+            if (++in_batch == batch_size) {
+                transaction->Commit();
+                transaction.reset();
+                result.transactions++;
+                in_batch = 0;
+            }
+        }
+        if (transaction) {
+            transaction->Commit();
+            result.transactions++;
+        }
+    } catch (const DatabaseException &e) {
+        result.aborted = true;
+        result.errors.push_back("line " + std::to_string(line_number) + ": " +
+                                e.what());
+    }
+    output.flush();
+    result.seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    return result;
+}
+}  // namespace AddressBook
@@ -0,0 +1,281 @@
+#include "ShardedDatabase.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include "DatabaseException.hpp"
+#include "Normalize.hpp"
+
+namespace AddressBook {
+/**
+ * @brief Opens every shard of a sharded database.
+ *
+ * @param uri_template The uri of the shards, with kShardPlaceholder where
+ * the shard number goes, e.g. `file:address-{shard}.db`
+ * @param shards The number of shards. It must stay the same for the life
+ * of the files, since it decides where records are.
+ * @param options The settings of every shard connection
+ * @throws DatabaseException If the template has no placeholder or a shard
+ * cannot be opened
+ */
+ShardedDatabase::ShardedDatabase(const std::string &uri_template,
+                                 std::size_t shards,
+                                 const DatabaseOptions &options) {
+    const std::string placeholder(kShardPlaceholder);
+    if (uri_template.find(placeholder) == std::string::npos) {
+        throw DatabaseException("The shard uri \"" + uri_template +
+                                "\" has no " + placeholder + ".");
+    }
+    if (shards == 0) {
+        throw DatabaseException("A sharded database needs at least 1 shard.");
+    }
+    for (std::size_t i = 0; i < shards; i++) {
+        std::string uri = uri_template;
+        for (std::size_t at = uri.find(placeholder); at != std::string::npos;
+             at = uri.find(placeholder, at)) {
+            uri.replace(at, placeholder.size(), std::to_string(i));
+        }
+        auto shard = std::make_unique<Shard>();
+        shard->db = std::make_unique<Database>(uri, options);
+        this->shards.push_back(std::move(shard));
+    }
+}
+
+std::size_t ShardedDatabase::ShardCount() const {
+    return this->shards.size();
+}
+
+/**
+ * @return std::size_t The shard holding the records with `last_name`, by
+ * the FNV-1a hash of the folded name, so that names differing in case or
+ * spacing are in the same shard
+ */
+std::size_t ShardedDatabase::ShardOf(const std::string &last_name) const {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : FoldName(last_name)) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return static_cast<std::size_t>(hash % this->shards.size());
+}
+
+/**
+ * @return int The global id of the new record
+ */
+int ShardedDatabase::AddRecord(const Record &record) {
+    std::size_t i = this->ShardOf(record.last_name);
+    std::lock_guard<std::mutex> lock(this->shards[i]->mutex);
+    return this->GlobalId(i, this->shards[i]->db->AddRecord(record));
+}
+
+/**
+ * @brief Adds a list of records, every shard adding its part in parallel
+ * in transactions of `batch_size` rows.
+ *
+ * @return std::size_t The number of records added
+ */
+std::size_t ShardedDatabase::AddRecords(const std::vector<Record> &records,
+                                        std::size_t batch_size) {
+    std::vector<std::vector<const Record *>> parts(this->shards.size());
+    for (const auto &record : records) {
+        parts[this->ShardOf(record.last_name)].push_back(&record);
+    }
+    auto added = this->ForEachShard([&](std::size_t i, Database &db) {
+        auto it = parts[i].begin();
+        return db.AddRecords(
+            [&](Record &record) {
+                if (it == parts[i].end()) {
+                    return false;
+                }
+                record = **it++;
+                return true;
+            },
+            batch_size);
+    });
+    std::size_t total = 0;
+    for (std::size_t count : added) {
+        total += count;
+    }
+    return total;
+}
+
+/**
+ * @brief Adds the records produced by `next`, reading at most `batch_size`
+ * records per shard at a time, so that memory use does not grow with the
+ * number of records. Every chunk is added by all shards in parallel.
+ *
+ * @param next Fills in the next record, returns false when there are none
+ * @param batch_size The number of rows per transaction of each shard
+ * @return std::size_t The number of records added
+ */
+std::size_t ShardedDatabase::AddRecords(
+    const std::function<bool(Record &)> &next, std::size_t batch_size) {
+    const std::size_t chunk_size = batch_size * this->shards.size();
+    std::vector<Record> chunk;
+    chunk.reserve(chunk_size);
+    std::size_t total = 0;
+    bool more = true;
+    while (more) {
+        chunk.clear();
+        Record record;
+        while (chunk.size() < chunk_size && (more = next(record))) {
+            chunk.push_back(std::move(record));
+        }
+        total += this->AddRecords(chunk, batch_size);
+    }
+    return total;
+}
+
+/**
+ * @brief Search all records matching any of the fields in record, on all
+ * shards in parallel.
+ *
+ * @return std::vector<Record> The matching records, by id
+ */
+std::vector<Record> ShardedDatabase::GetRecords(const Record &record) const {
+    return this->Merge(this->ForEachShard(
+        [&](std::size_t, Database &db) { return db.GetRecords(record); }));
+}
+
+Record ShardedDatabase::GetRecordByName(const std::string &first_name,
+                                        const std::string &last_name) const {
+    std::size_t i = this->ShardOf(last_name);
+    std::lock_guard<std::mutex> lock(this->shards[i]->mutex);
+    Record record = this->shards[i]->db->GetRecordByName(first_name, last_name);
+    if (record.id != -1) {
+        record.id = this->GlobalId(i, record.id);
+    }
+    return record;
+}
+
+/**
+ * @return std::vector<Record> The records of all shards, read in parallel,
+ * by id
+ */
+std::vector<Record> ShardedDatabase::GetAllRecords() const {
+    return this->Merge(this->ForEachShard(
+        [](std::size_t, Database &db) { return db.GetAllRecords(); }));
+}
+
+int ShardedDatabase::DeleteRecord(const std::string &first_name,
+                                  const std::string &last_name) {
+    Shard &shard = *this->shards[this->ShardOf(last_name)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.db->DeleteRecord(first_name, last_name);
+}
+
+int ShardedDatabase::DeleteRecord(const Record &record) {
+    Shard &shard = *this->shards[this->ShardOf(record.last_name)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.db->DeleteRecord(record);
+}
+
+/**
+ * @param id The global id of the record
+ */
+int ShardedDatabase::DeleteRecord(int id) {
+    if (id < 0) {
+        return 0;
+    }
+    std::size_t n = this->shards.size();
+    Shard &shard = *this->shards[static_cast<std::size_t>(id) % n];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.db->DeleteRecord(static_cast<int>(id / n));
+}
+
+/**
+ * @brief Updates a record by its global id. If the new last name belongs
+ * to another shard, the record is moved there and gets a new id. The move
+ * adds the record to the new shard before it deletes it from the old one,
+ * and commits in that order, so a failure can at worst leave the record
+ * in both shards, never in neither.
+ *
+ * @param id The global id of the record
+ * @param record The new values of the record
+ * @param new_id If not null, set to the global id of the record after the
+ * update, or -1 if no record has the id `id`
+ * @return int The number of rows affected, 0 or 1
+ */
+int ShardedDatabase::UpdateRecord(int id, const Record &record, int *new_id) {
+    if (new_id != nullptr) {
+        *new_id = -1;
+    }
+    if (id < 0) {
+        return 0;
+    }
+    std::size_t n = this->shards.size();
+    std::size_t from = static_cast<std::size_t>(id) % n;
+    std::size_t to = this->ShardOf(record.last_name);
+    int rowid = static_cast<int>(id / n);
+    if (from == to) {
+        std::lock_guard<std::mutex> lock(this->shards[from]->mutex);
+        int rows = this->shards[from]->db->UpdateRecord(rowid, record);
+        if (rows > 0 && new_id != nullptr) {
+            *new_id = id;
+        }
+        return rows;
+    }
+    Database &source = *this->shards[from]->db;
+    Database &target = *this->shards[to]->db;
+    std::scoped_lock lock(this->shards[from]->mutex, this->shards[to]->mutex);
+    Database::Transaction added(target);
+    int moved = this->GlobalId(to, target.AddRecord(record));
+    Database::Transaction deleted(source);
+    if (source.DeleteRecord(rowid) == 0) {
+        // Nothing to move, both transactions roll back
+        return 0;
+    }
+    added.Commit();
+    deleted.Commit();
+    if (new_id != nullptr) {
+        *new_id = moved;
+    }
+    return 1;
+}
+
+/**
+ * @brief Removes all records from all shards in parallel.
+ */
+void ShardedDatabase::ClearRecords() {
+    this->ForEachShard([](std::size_t, Database &db) { db.ClearRecords(); });
+}
+
+/**
+ * @return int The global id of the record with `rowid` in `shard`
+ * @throws DatabaseException If the id does not fit in an int
+ */
+int ShardedDatabase::GlobalId(std::size_t shard, int rowid) const {
+    std::int64_t id = static_cast<std::int64_t>(rowid) *
+                          static_cast<std::int64_t>(this->shards.size()) +
+                      static_cast<std::int64_t>(shard);
+    if (id > std::numeric_limits<int>::max()) {
+        throw DatabaseException("The record " + std::to_string(rowid) +
+                                " of shard " + std::to_string(shard) +
+                                " has no id that fits in an int.");
+    }
+    return static_cast<int>(id);
+}
+
+/**
+ * @brief Concatenates the results of the shards, with global ids, in id
+ * order.
+ */
+std::vector<Record> ShardedDatabase::Merge(
+    std::vector<std::vector<Record>> results) const {
+    std::size_t total = 0;
+    for (const auto &result : results) {
+        total += result.size();
+    }
+    std::vector<Record> records;
+    records.reserve(total);
+    for (std::size_t i = 0; i < results.size(); i++) {
+        for (auto &record : results[i]) {
+            record.id = this->GlobalId(i, record.id);
+            records.push_back(std::move(record));
+        }
+    }
+    std::sort(records.begin(), records.end(),
+              [](const Record &a, const Record &b) { return a.id < b.id; });
+    return records;
+}
+}  // namespace AddressBook
@@ -0,0 +1,333 @@
+#include "Snapshot.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include "DatabaseException.hpp"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AddressBook {
+namespace {
+const char kMagic[8] = {'A', 'B', 'S', 'N', 'A', 'P', '\0', '\0'};
+// The size of the fixed part of a record: the id and four lengths
+const std::size_t kRecordHeaderSize = 4 + 4 * 4;
+// How much is buffered before it is written to the file
+const std::size_t kWriteBufferSize = 1 << 20;
+
+void PutU32(std::string &out, std::uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+void PutU64(std::string &out, std::uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+std::uint32_t GetU32(const char *in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i]))
+                 << (8 * i);
+    }
+    return value;
+}
+
+std::uint64_t GetU64(const char *in) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i]))
+                 << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Continues a 64-bit FNV-1a hash over `size` bytes.
+ */
+std::uint64_t Fnv1a(std::uint64_t hash, const char *data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+const std::uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+
+std::string Header(std::uint64_t records, std::uint64_t checksum) {
+    std::string header(kMagic, sizeof(kMagic));
+    PutU32(header, SnapshotView::kVersion);
+    PutU32(header, 0);
+    PutU64(header, records);
+    PutU64(header, checksum);
+    return header;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+}  // namespace
+
+/**
+ * @brief Maps a snapshot file and checks its header, checksum and records.
+ *
+ * @param path The path to the snapshot
+ * @throws DatabaseException If the file cannot be read or is not a valid
+ * snapshot
+ */
+SnapshotView::SnapshotView(const std::string &path) {
+    this->Map(path);
+    try {
+        this->Validate(path);
+    } catch (...) {
+        this->Unmap();
+        throw;
+    }
+}
+
+SnapshotView::~SnapshotView() { this->Unmap(); }
+
+/**
+ * @return std::size_t The number of records in the snapshot
+ */
+std::size_t SnapshotView::Size() const { return this->offsets.size(); }
+
+/**
+ * @return RecordView The i-th record, pointing into the mapped file
+ */
+RecordView SnapshotView::operator[](std::size_t i) const {
+    const char *record = this->data + this->offsets[i];
+    std::uint32_t lengths[4];
+    for (int field = 0; field < 4; field++) {
+        lengths[field] = GetU32(record + 4 + 4 * field);
+    }
+    const char *text = record + kRecordHeaderSize;
+    RecordView view;
+    view.id = static_cast<int>(GetU32(record));
+    view.first_name = std::string_view(text, lengths[0]);
+    text += lengths[0];
+    view.last_name = std::string_view(text, lengths[1]);
+    text += lengths[1];
+    view.email = std::string_view(text, lengths[2]);
+    text += lengths[2];
+    view.telephone = std::string_view(text, lengths[3]);
+    return view;
+}
+
+/**
+ * @return std::uint64_t The size of the snapshot file
+ */
+std::uint64_t SnapshotView::FileBytes() const { return this->size; }
+
+void SnapshotView::Map(const std::string &path) {
+    const std::string error = "Cannot map snapshot \"" + path + "\".";
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw DatabaseException(error);
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        throw DatabaseException(error);
+    }
+    this->size = static_cast<std::size_t>(file_size.QuadPart);
+    this->mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (this->mapping == nullptr) {
+        throw DatabaseException(error);
+    }
+    this->data = static_cast<const char *>(
+        MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (this->data == nullptr) {
+        CloseHandle(this->mapping);
+        this->mapping = nullptr;
+        throw DatabaseException(error);
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw DatabaseException(error);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        close(fd);
+        throw DatabaseException(error);
+    }
+    this->size = static_cast<std::size_t>(status.st_size);
+    void *address = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw DatabaseException(error);
+    }
+    // Records are read front to back, so let the kernel read ahead
+    madvise(address, this->size, MADV_SEQUENTIAL);
+    this->data = static_cast<const char *>(address);
+#endif
+}
+
+void SnapshotView::Unmap() {
+    if (this->data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(this->data);
+    CloseHandle(this->mapping);
+    this->mapping = nullptr;
+#else
+    munmap(const_cast<char *>(this->data), this->size);
+#endif
+    this->data = nullptr;
+}
+
+/**
+ * @brief Checks the header and checksum, and indexes the records while
+ * making sure none of them runs past the end of the file.
+ */
+void SnapshotView::Validate(const std::string &path) {
+    const std::string error = "\"" + path + "\" is not a valid snapshot: ";
+    if (this->size < kHeaderSize ||
+        std::memcmp(this->data, kMagic, sizeof(kMagic)) != 0) {
+        throw DatabaseException(error + "bad header.");
+    }
+    if (GetU32(this->data + 8) != kVersion) {
+        throw DatabaseException(error + "unsupported version " +
+                                std::to_string(GetU32(this->data + 8)) + ".");
+    }
+    std::uint64_t records = GetU64(this->data + 16);
+    std::uint64_t checksum = GetU64(this->data + 24);
+    if (Fnv1a(kFnvOffsetBasis, this->data + kHeaderSize,
+              this->size - kHeaderSize) != checksum) {
+        throw DatabaseException(error + "checksum mismatch.");
+    }
+    // Every record takes at least its fixed part, which bounds the count
+    if (records > (this->size - kHeaderSize) / kRecordHeaderSize) {
+        throw DatabaseException(error + "truncated.");
+    }
+    this->offsets.reserve(static_cast<std::size_t>(records));
+    std::size_t offset = kHeaderSize;
+    for (std::uint64_t i = 0; i < records; i++) {
+        if (this->size - offset < kRecordHeaderSize) {
+            throw DatabaseException(error + "truncated.");
+        }
+        std::uint64_t length = kRecordHeaderSize;
+        for (int field = 0; field < 4; field++) {
+            length += GetU32(this->data + offset + 4 + 4 * field);
+        }
+        if (this->size - offset < length) {
+            throw DatabaseException(error + "truncated.");
+        }
+        this->offsets.push_back(offset);
+        offset += static_cast<std::size_t>(length);
+    }
+    if (offset != this->size) {
+        throw DatabaseException(error + "trailing data.");
+    }
+}
+
+/**
+ * @brief Writes every record of the database to a snapshot file, streaming
+ * them from the query through a large buffer.
+ *
+ * @param db The database to read from
+ * @param path The path to the snapshot, overwritten if it exists
+ * @return SnapshotResult The number of records and bytes written
+ * @throws DatabaseException If the file cannot be written
+ */
+SnapshotResult SaveSnapshot(const Database &db, const std::string &path) {
+    auto start = std::chrono::steady_clock::now();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw DatabaseException("Cannot write snapshot \"" + path + "\".");
+    }
+    // The header is rewritten with the count and checksum at the end
+    file.write(std::string(SnapshotView::kHeaderSize, '\0').data(),
+               SnapshotView::kHeaderSize);
+    SnapshotResult result;
+    std::uint64_t checksum = kFnvOffsetBasis;
+    std::string buffer;
+    buffer.reserve(kWriteBufferSize);
+    auto flush = [&]() {
+        checksum = Fnv1a(checksum, buffer.data(), buffer.size());
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        result.bytes += buffer.size();
+        buffer.clear();
+    };
+    db.Scan([&](const RecordView &record) {
+        const std::string_view fields[] = {record.first_name, record.last_name,
+                                           record.email, record.telephone};
+        PutU32(buffer, static_cast<std::uint32_t>(record.id));
+        for (const auto &field : fields) {
+            PutU32(buffer, static_cast<std::uint32_t>(field.size()));
+        }
+        for (const auto &field : fields) {
+            buffer.append(field);
+        }
+        result.records++;
+        if (buffer.size() >= kWriteBufferSize) {
+            flush();
+        }
+        return true;
+    });
+    flush();
+    file.seekp(0);
+    std::string header = Header(result.records, checksum);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    file.close();
+    if (!file) {
+        throw DatabaseException("Cannot write snapshot \"" + path + "\".");
+    }
+    result.bytes += header.size();
+    result.seconds = SecondsSince(start);
+    return result;
+}
+
+/**
+ * @brief Adds the records of a snapshot file to the database, in
+ * transactions of `batch_size` records. The records get new ids, like
+ * imported ones.
+ *
+ * @param db The database to write to
+ * @param path The path to the snapshot
+ * @param batch_size The number of records per transaction
+ * @return SnapshotResult The number of records loaded and the file size
+ * @throws DatabaseException If the snapshot is invalid or a batch fails
+ */
+SnapshotResult LoadSnapshot(Database &db, const std::string &path,
+                            std::size_t batch_size) {
+    auto start = std::chrono::steady_clock::now();
+    SnapshotView snapshot(path);
+    std::size_t next = 0;
+    SnapshotResult result;
+    result.records = db.AddRecords(
+        [&](Record &record) {
+            if (next == snapshot.Size()) {
+                return false;
+            }
+            RecordView view = snapshot[next++];
+            record.first_name.assign(view.first_name);
+            record.last_name.assign(view.last_name);
+            record.email.assign(view.email);
+            record.telephone.assign(view.telephone);
+            return true;
+        },
+        batch_size);
+    result.bytes = snapshot.FileBytes();
+    result.seconds = SecondsSince(start);
+    return result;
+}
+}  // namespace AddressBook
@@ -7,54 +7,628 @@
 #include <nlohmann/json.hpp>
 #include "Database.hpp"
 #include "DatabaseException.hpp"
+#include "Dedupe.hpp"
 #include "Record.hpp"
+#include "RecordImporter.hpp"
+#include "RecordWriter.hpp"
+#include "ScriptRunner.hpp"
+#include "ShardedDatabase.hpp"
+#include "Snapshot.hpp"
 
 using json = nlohmann::json;
 using namespace AddressBook;
 
+// The maximum number of records printed by the search command
+const int kSearchLimit = 20;
+// The maximum number of changes printed by the changes command
+const int kChangesLimit = 100;
+// The byte budget of the record cache when config.json does not set one
+const std::size_t kDefaultCacheBudget = 4 * 1024 * 1024;
+
+/**
+ * @brief Parses the `--format name` arguments of the list and get commands
+ * @param os The ostream to print an error to
+ * @param flag Must be "--format"
+ * @param name The name of the format
+ * @param format Set to the format
+ * @return Whether the arguments are valid
+*/
+bool parse_format(std::ostream &os, const std::string &flag,
+                  const std::string &name, OutputFormat &format) {
+    if (flag != "--format") {
+        os << "Unknown option \"" << flag << "\"." << std::endl;
+        return false;
+    }
+    if (!RecordWriter::FormatFromName(name, format)) {
+        os << "Unknown format \"" << name
+           << "\", expected text, table, csv or jsonl." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Prints the number of records written, unless the format is meant
+ * for other programs to read
+ * @param os The ostream to print to
+ * @param format The format the records were written in
+ * @param count The number of records written
+*/
+void print_total(std::ostream &os, OutputFormat format, std::size_t count) {
+    if (format == OutputFormat::Text || format == OutputFormat::Table) {
+        os << count << " records in total." << '\n';
+    }
+    os.flush();
+}
+
 /**
  * @brief Prints a list of records to the ostream
  * @param os The ostream to print to
  * @param records A list of records to be printed
+ * @param format The format of the records
 */
-void print_records(std::ostream &os, const std::vector<Record> &records) {
-    for (auto record: records) {
-        os << record;
+void print_records(std::ostream &os, const std::vector<Record> &records,
+                   OutputFormat format = OutputFormat::Text) {
+    {
+        RecordWriter writer(os, format);
+        for (const auto &record: records) {
+            writer.Write(record);
+        }
+    }
+    print_total(os, format, records.size());
+}
+
+/**
+ * @brief Prints every record of the database as it is read
+ * @param os The ostream to print to
+ * @param db The database to read from
+ * @param format The format of the records
+*/
+void print_all(std::ostream &os, const Database &db, OutputFormat format) {
+    std::size_t count;
+    {
+        // Stream the rows so memory use does not grow with the table
+        RecordWriter writer(os, format);
+        count = db.Scan([&](const RecordView &record) {
+            writer.Write(record);
+            return true;
+        });
+    }
+    print_total(os, format, count);
+}
+
+/**
+ * @brief Prints a page of records and the command to get the next page
+ * @param os The ostream to print to
+ * @param db The database to read from
+ * @param limit The maximum number of records in the page
+ * @param after_id The id of the last record of the previous page
+*/
+void print_page(std::ostream &os, const Database &db, int limit, int after_id) {
+    if (limit <= 0) {
+        os << "The limit must be positive." << std::endl;
+        return;
+    }
+    auto records = db.GetRecordsPage(after_id, limit);
+    {
+        RecordWriter writer(os, OutputFormat::Text);
+        for (const auto &record: records) {
+            writer.Write(record);
+        }
+    }
+    os << records.size() << " records in this page." << '\n';
+    if (static_cast<int>(records.size()) == limit) {
+        os << "Next page: list " << limit << ' ' << records.back().id << '\n';
+    }
+    os.flush();
+}
+
+/**
+ * @brief Prints the rows affected by each batch of a bulk operation
+ * @param os The ostream to print to
+ * @param batches The number of rows affected by each batch
+*/
+void print_batches(std::ostream &os, const std::vector<int> &batches) {
+    int total = 0;
+    for (std::size_t i = 0; i < batches.size(); i++) {
+        os << "Batch " << i + 1 << ": " << batches[i] << " rows affected." << '\n';
+        total += batches[i];
+    }
+    os << total << " rows affected." << std::endl;
+}
+
+/**
+ * @brief Prints the changes made after a sequence number
+ * @param os The ostream to print to
+ * @param db The database to read from
+ * @param sequence The sequence of the last change already seen
+*/
+void print_changes(std::ostream &os, const Database &db, long long sequence) {
+    static const char *const types[] = {"insert", "update", "delete", "clear"};
+    std::vector<Change> changes;
+    try {
+        changes = db.ChangesSince(sequence, kChangesLimit);
+    } catch (const DatabaseException &e) {
+        os << e.what() << std::endl;
+        return;
+    }
+    for (const auto &change : changes) {
+        os << "Change " << change.sequence << ": "
+           << types[static_cast<int>(change.type)] << '\n';
+        if (change.type == ChangeType::Insert ||
+            change.type == ChangeType::Update) {
+            os << change.record;
+        } else if (change.type == ChangeType::Delete) {
+            os << "#" << change.record.id << '\n';
+        }
         os << std::string(30, '-') << '\n';
     }
-    os << records.size() << " records in total." << std::endl;
+    os << changes.size() << " changes." << '\n';
+    if (static_cast<int>(changes.size()) == kChangesLimit) {
+        os << "Next changes: changes " << changes.back().sequence << '\n';
+    }
+    os.flush();
 }
 
 /**
- * @brief Tries to retrieve the URI of the database through the command line
- * arguments and JSON file
+ * @brief Prints the pairs of records that likely describe the same contact
+ * @param os The ostream to print to
+ * @param db The database to search
+ * @param threshold The minimum score of a pair, from 0 to 1
+*/
+void print_duplicates(std::ostream &os, const Database &db, double threshold) {
+    if (threshold < 0 || threshold > 1) {
+        os << "The threshold must be between 0 and 1." << std::endl;
+        return;
+    }
+    DedupeOptions options;
+    options.threshold = threshold;
+    auto duplicates = FindDuplicates(db, options);
+    for (const auto &duplicate : duplicates) {
+        os << "Score " << duplicate.score << '\n';
+        os << duplicate.first << duplicate.second;
+        os << std::string(30, '-') << '\n';
+    }
+    os << duplicates.size() << " likely duplicates." << std::endl;
+}
+
+/**
+ * @brief Parses a record id typed by the user
+ * @param text The id
+ * @return The id, or -1 if it is not a number
+*/
+int parse_id(const std::string &text) {
+    try {
+        std::size_t end;
+        int id = std::stoi(text, &end);
+        return end == text.size() ? id : -1;
+    } catch (const std::logic_error &) {
+        return -1;
+    }
+}
+
+/**
+ * @brief Imports the records in a CSV or JSON Lines file and prints a summary
+ * @param os The ostream to print to
+ * @param db The Database or ShardedDatabase to import into
+ * @param path The file to import, streamed row by row
+ * @param batch_size The number of rows per transaction
+*/
+template <typename DatabaseType>
+void import_file(std::ostream &os, DatabaseType &db, const std::string &path,
+                 std::size_t batch_size) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        os << "Cannot open \"" << path << "\"." << std::endl;
+        return;
+    }
+    ImportResult result = ImportRecords(
+        db, file, RecordImporter::FormatFromPath(path), batch_size);
+    for (const auto &error : result.errors) {
+        os << "Skipped " << error << '\n';
+    }
+    os << result.imported << " records imported, " << result.skipped
+       << " rows skipped in " << result.seconds << " s ("
+       << static_cast<std::size_t>(
+              result.seconds > 0 ? result.imported / result.seconds : 0)
+       << " rows/sec)." << std::endl;
+}
+
+/**
+ * @brief Saves the database to or loads it from a snapshot file
+ * @param os The ostream to print to
+ * @param db The database
+ * @param action "save" or "load"
+ * @param path The path to the snapshot
+*/
+void snapshot_file(std::ostream &os, Database &db, const std::string &action,
+                   const std::string &path) {
+    SnapshotResult result;
+    try {
+        if (action == "save") {
+            result = SaveSnapshot(db, path);
+        } else if (action == "load") {
+            result = LoadSnapshot(db, path);
+        } else {
+            os << "Unknown action \"" << action
+               << "\", expected \"save\" or \"load\"." << std::endl;
+            return;
+        }
+    } catch (const DatabaseException &e) {
+        os << e.what() << std::endl;
+        return;
+    }
+    os << result.records << " records " << (action == "save" ? "saved" : "loaded")
+       << " (" << result.bytes << " bytes) in " << result.seconds << " s."
+       << std::endl;
+}
+
+/**
+ * @brief Reads the JSON configuration file
  * 
- * @param argc argc of main
- * @param argv argv of main
  * @param fname Filename of the JSON file
- * @return The URI string
+ * @return The configuration, an empty object if the file does not exist
  * @throws json::parse_error If the JSON is invalid
- * @throws json::out_of_range If `database` key is not found
 */
-std::string getUri(int argc, char** argv, const std::string& fname = "config.json") {
+json getConfig(const std::string& fname = "config.json") {
     std::ifstream json_file(fname);
-    if (argc >= 2) {
-        return argv[1];
-    }
-    else if (json_file.is_open()) {
-        // Attempts to open the JSON file
-        json config;
+    json config = json::object();
+    if (json_file.is_open()) {
         json_file >> config;
-        return config.at("database");
     }
-    else {
-        return "";
+    return config;
+}
+
+/**
+ * @brief The command line arguments of the program
+ */
+struct Arguments {
+    std::string uri;     // The URI of the database, empty if not given
+    std::string script;  // The script of --exec, "-" for --stdin-batch
+};
+
+/**
+ * @brief Parses `[uri] [--exec script | --stdin-batch]`
+ * 
+ * @param argc argc of main
+ * @param argv argv of main
+ * @param arguments Set to the parsed arguments
+ * @return Whether the arguments are valid
+*/
+bool parseArguments(int argc, char** argv, Arguments& arguments) {
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        if (argument == "--exec" && i + 1 < argc && arguments.script.empty()) {
+            arguments.script = argv[++i];
+        } else if (argument == "--stdin-batch" && arguments.script.empty()) {
+            arguments.script = "-";
+        } else if (argument.rfind("--", 0) != 0 && arguments.uri.empty()) {
+            arguments.uri = argument;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tries to retrieve the URI of the database through the command line
+ * arguments and the configuration
+ * 
+ * @param arguments The command line arguments
+ * @param config The configuration read from config.json
+ * @return The URI string
+ * @throws json::type_error If `database` is not a string
+*/
+std::string getUri(const Arguments& arguments, const json& config) {
+    if (!arguments.uri.empty()) {
+        return arguments.uri;
+    }
+    return config.value("database", "");
+}
+
+/**
+ * @brief Builds the connection settings from the `options` object of the
+ * configuration. `preset` selects a DatabaseOptions preset, and the other
+ * keys, named as the fields of DatabaseOptions, override it.
+ * 
+ * @param config The configuration read from config.json
+ * @return The connection settings
+ * @throws json::type_error If a key has the wrong type
+ * @throws DatabaseException If the preset does not exist
+*/
+DatabaseOptions getOptions(const json& config) {
+    if (!config.contains("options")) {
+        return DatabaseOptions();
+    }
+    const json& section = config.at("options");
+    DatabaseOptions options =
+        DatabaseOptions::FromPreset(section.value("preset", "default"));
+    options.busy_timeout_ms =
+        section.value("busy_timeout_ms", options.busy_timeout_ms);
+    options.journal_mode = section.value("journal_mode", options.journal_mode);
+    options.synchronous = section.value("synchronous", options.synchronous);
+    options.temp_store = section.value("temp_store", options.temp_store);
+    if (section.contains("cache_size")) {
+        options.cache_size = section.at("cache_size").get<int>();
+    }
+    if (section.contains("mmap_size")) {
+        options.mmap_size = section.at("mmap_size").get<std::int64_t>();
+    }
+    if (section.contains("page_size")) {
+        options.page_size = section.at("page_size").get<int>();
+    }
+    options.compressed = section.value("compressed", options.compressed);
+    return options;
+}
+
+/**
+ * @brief Enables the record cache if the `cache` object of the configuration
+ * has `"enabled": true`. `byte_budget` sets the size of the cache.
+ * 
+ * @param db The database
+ * @param config The configuration read from config.json
+*/
+void applyCacheConfig(Database& db, const json& config) {
+    if (!config.contains("cache")) {
+        return;
+    }
+    const json& cache = config.at("cache");
+    if (cache.value("enabled", false)) {
+        db.EnableCache(cache.value("byte_budget", kDefaultCacheBudget));
     }
 }
 
+/**
+ * @brief Enables the statement metrics if the `metrics` object of the
+ * configuration has `"enabled": true`.
+ * 
+ * @param db The database
+ * @param config The configuration read from config.json
+*/
+void applyMetricsConfig(Database& db, const json& config) {
+    if (!config.contains("metrics") ||
+        !config.at("metrics").value("enabled", false)) {
+        return;
+    }
+    try {
+        db.EnableMetrics();
+    } catch (const DatabaseException& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+/**
+ * @brief Prints every record of all shards
+ * @param os The ostream to print to
+ * @param db The sharded database to read from
+ * @param format The format of the records
+*/
+void print_all(std::ostream &os, const ShardedDatabase &db, OutputFormat format) {
+    print_records(os, db.GetAllRecords(), format);
+}
+
+/**
+ * @brief Adds the commands that work the same on a Database and on a
+ * ShardedDatabase: add, import, list, get, delete and clear.
+ * 
+ * @param menu The menu to add the commands to
+ * @param db The Database or ShardedDatabase the commands run on
+*/
+template <typename DatabaseType>
+void insertRecordCommands(cli::Menu& menu, DatabaseType& db) {
+    menu.Insert(
+        "add",
+        {"first_name", "last_name", "email", "telephone"},
+        [&](std::ostream &, const std::string &first_name, const std::string &last_name, const std::string &email, const std::string &telephone) {
+            db.AddRecord(Record({first_name, last_name, email, telephone}));
+        },
+        "Add a set of record in first_name, last_name, email, telephone "
+        "order."
+    );
+    menu.Insert(
+        "import",
+        {"file"},
+        [&](std::ostream &ostream, const std::string &path) {
+            import_file(ostream, db, path, Database::kDefaultBatchSize);
+        },
+        "Import records from a CSV (first_name,last_name,email,telephone) "
+        "or JSON Lines (.jsonl) file."
+    );
+    menu.Insert(
+        "import",
+        {"file", "batch_size"},
+        [&](std::ostream &ostream, const std::string &path, int batch_size) {
+            if (batch_size <= 0) {
+                ostream << "The batch size must be positive." << std::endl;
+                return;
+            }
+            import_file(ostream, db, path, batch_size);
+        },
+        "Import records from a file, committing every batch_size rows."
+    );
+    menu.Insert(
+        "list",
+        [&](std::ostream &ostream) {
+            print_all(ostream, db, OutputFormat::Text);
+        },
+        "List all records."
+    );
+    menu.Insert(
+        "list",
+        {"--format", "format"},
+        [&](std::ostream &ostream, const std::string &flag, const std::string &name) {
+            OutputFormat format;
+            if (parse_format(ostream, flag, name, format)) {
+                print_all(ostream, db, format);
+            }
+        },
+        "List all records as text, table, csv or jsonl."
+    );
+    menu.Insert(
+        "get",
+        {"first_name", "last_name"},
+        [&](std::ostream &ostream, const std::string &first_name, const std::string &last_name) {
+            Record record = db.GetRecordByName(first_name, last_name);
+            if (record.id == -1) {
+                ostream << "The person \"" << first_name
+                    << ' ' << last_name << "\" does not exist." << std::endl;
+            }
+            else {
+                ostream << record << std::flush;
+            }
+        },
+        "Get a record by a person's first and last name."
+    );
+    menu.Insert(
+        "get",
+        {"first_name", "last_name", "--format", "format"},
+        [&](std::ostream &ostream, const std::string &first_name, const std::string &last_name,
+            const std::string &flag, const std::string &name) {
+            OutputFormat format;
+            if (!parse_format(ostream, flag, name, format)) {
+                return;
+            }
+            Record record = db.GetRecordByName(first_name, last_name);
+            if (record.id == -1) {
+                ostream << "The person \"" << first_name
+                    << ' ' << last_name << "\" does not exist." << std::endl;
+                return;
+            }
+            RecordWriter(ostream, format).Write(record);
+        },
+        "Get a record by name as text, table, csv or jsonl."
+    );
+    menu.Insert(
+        "delete",
+        { "id" },
+        [&](std::ostream& os, int id) {
+            int rows_affected = db.DeleteRecord(id);
+            if (rows_affected == 0) {
+                os << "Record #" << id << " does not exist." << '\n';
+            }
+            os << rows_affected << " rows affected." << std::endl;
+        },
+        "Deletes a record by its id."
+    );
+    menu.Insert(
+        "clear",
+        {"confirmation"},
+        [&](std::ostream& os, const std::string &confirmation) {
+            std::string up_string(confirmation);
+            std::transform(
+                up_string.begin(),
+                up_string.end(),
+                up_string.begin(),
+                ::toupper
+            );
+            if (up_string == "YES") {
+                db.ClearRecords();
+                os << "All data cleared." << std::endl;
+            }
+            else {
+                os << "Type \"yes\" to confirm removing all data in the database." << std::endl;
+            }
+        },
+        "Deletes all records. Use \"yes\" to confirm the change."
+    );
+}
+
+/**
+ * @brief Runs the command line on a sharded database, with the commands
+ * ShardedDatabase supports.
+ * 
+ * @param shards The `shards` object of the configuration: `uri`, the uri
+ * template of the shard files, and `count`, the number of shards
+ * @param options The settings of every shard connection
+*/
+void runSharded(const json& shards, const DatabaseOptions& options) {
+    ShardedDatabase db(shards.at("uri").get<std::string>(),
+                       shards.at("count").get<std::size_t>(), options);
+    std::cout << "Using " << db.ShardCount() << " shards at \""
+              << shards.at("uri").get<std::string>() << "\"" << std::endl;
+    auto menu = std::make_unique<cli::Menu>("db_menu");
+    insertRecordCommands(*menu, db);
+    menu->Insert(
+        "update",
+        {"id", "first-name", "last-name", "email", "telephone"},
+        [&](std::ostream& ostream, int id,
+            const std::string& first_name,
+            const std::string& last_name,
+            const std::string& email,
+            const std::string& telephone) {
+                int new_id;
+                int rows_affected = db.UpdateRecord(
+                    id, Record({first_name, last_name, email, telephone}),
+                    &new_id);
+                if (rows_affected > 0 && new_id != id) {
+                    ostream << "Record #" << id << " is now #" << new_id
+                            << "." << '\n';
+                }
+                ostream << rows_affected << " rows affected." << std::endl;
+        },
+        "Update the record by its id. A new last name may give it a new id."
+    );
+    cli::Cli mycli(std::move(menu));
+    cli::CliFileSession file_session(mycli);
+    file_session.Start();
+}
+
+/**
+ * @brief Runs a script of commands without the interactive menu. The
+ * records the script reads go to stdout, the summary and errors to stderr.
+ * 
+ * @param db The database
+ * @param path The script, "-" for stdin
+ * @return The exit code, 0 if every line of the script ran
+*/
+int runScript(Database& db, const std::string& path) {
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file.is_open()) {
+            std::cerr << "Cannot open \"" << path << "\"." << std::endl;
+            return -1;
+        }
+    }
+    std::istream& script = path == "-" ? std::cin : file;
+    ScriptResult result = RunScript(db, script, std::cout);
+    for (const auto& error : result.errors) {
+        std::cerr << "Error at " << error << '\n';
+    }
+    if (result.aborted) {
+        std::cerr << "Stopped. The commands since the last commit were "
+                     "rolled back." << '\n';
+    }
+    std::cerr << result.commands << " commands in " << result.seconds
+              << " s ("
+              << static_cast<std::size_t>(
+                     result.seconds > 0 ? result.commands / result.seconds : 0)
+              << " commands/sec), " << result.rows << " rows changed in "
+              << result.transactions << " transactions, " << result.skipped
+              << " lines skipped." << std::endl;
+    return result.aborted || result.skipped > 0 ? -1 : 0;
+}
+
 int main(int argc, char** argv) {
     try {
-        std::string uri = getUri(argc, argv);
+        Arguments arguments;
+        if (!parseArguments(argc, argv, arguments)) {
+            std::cerr << "Usage: address-book [uri] "
+                         "[--exec script | --stdin-batch]" << std::endl;
+            return -1;
+        }
+        json config = getConfig();
+        if (arguments.uri.empty() && config.contains("shards")) {
+            if (!arguments.script.empty()) {
+                std::cerr << "Scripts run on one database. Provide its URI "
+                             "as an argument." << std::endl;
+                return -1;
+            }
+            runSharded(config.at("shards"), getOptions(config));
+            return 0;
+        }
+        std::string uri = getUri(arguments, config);
         if (uri == "") {
             std::cerr << 
                 "The URI to the database file is not found. "
@@ -62,6 +636,13 @@ int main(int argc, char** argv) {
                 " the program or specify it with config.json.";
             return -1;
         }
+        if (!arguments.script.empty()) {
+            // No banner, so that stdout only holds what the script reads
+            Database db(uri, getOptions(config));
+            applyCacheConfig(db, config);
+            applyMetricsConfig(db, config);
+            return runScript(db, arguments.script);
+        }
         // Load database
         std::cout << "Address Book Program\n"
                      "--------------------\n"
@@ -69,56 +650,85 @@ int main(int argc, char** argv) {
                   << uri
                   << "\""
                   << std::endl;
-        Database db(uri);
+        Database db(uri, getOptions(config));
+        std::cout << "Connection settings:\n"
+                  << db.GetEffectiveOptions()
+                  << std::endl;
+        applyCacheConfig(db, config);
+        applyMetricsConfig(db, config);
+        // Transactions opened with "begin", innermost last. Those left open
+        // on exit are rolled back.
+        std::vector<std::unique_ptr<Database::Transaction>> transactions;
         auto menu = std::make_unique<cli::Menu>("db_menu");
         menu->Insert(
-            "add",
-            {"first_name", "last_name", "email", "telephone"},
-            [&](std::ostream &ostream, const std::string &first_name, const std::string &last_name, const std::string &email, const std::string &telephone) {
-                AddressBook::Record myrecord;
-                myrecord.first_name = first_name;
-                myrecord.last_name = last_name;
-                myrecord.email = email;
-                myrecord.telephone = telephone;
-                db.AddRecord(myrecord);
-            },
-            "Add a set of record in first_name, last_name, email, telephone "
-            "order."
-            );
+            "snapshot",
+            {"save|load", "path"},
+            [&](std::ostream &ostream, const std::string &action,
+                const std::string &path) {
+                snapshot_file(ostream, db, action, path);
+            },
+            "Save all records to a binary snapshot file, or add the records "
+            "of one to the database."
+        );
+        menu->Insert(
+            "backup",
+            {"path"},
+            [&](std::ostream &ostream, const std::string &path) {
+                try {
+                    db.Backup(path);
+                } catch (const DatabaseException &e) {
+                    ostream << "Backup failed: " << e.what() << std::endl;
+                    return;
+                }
+                ostream << "Database copied to \"" << path << "\"." << std::endl;
+            },
+            "Copy the database file to path while it stays usable."
+        );
         menu->Insert(
             "list",
-            [&](std::ostream &ostream) {
-                auto records = db.GetAllRecords();
-                print_records(ostream, records);
+            {"limit"},
+            [&](std::ostream &ostream, int limit) {
+                print_page(ostream, db, limit, 0);
             },
-            "List all records in the table."
+            "List the first limit records."
         );
         menu->Insert(
-            "get",
-            {"first_name", "last_name"},
-            [&](std::ostream &ostream, const std::string &first_name, const std::string &last_name) {
-                AddressBook::Record record = db.GetRecordByName(first_name, last_name);
-                if (record.id == -1) {
-                    ostream << "The person \"" << first_name
-                        << ' ' << last_name << "\" does not exist." << std::endl;
-                }
-                else {
-                    ostream << record;
+            "list",
+            {"limit", "after_id"},
+            [&](std::ostream &ostream, int limit, int after_id) {
+                print_page(ostream, db, limit, after_id);
+            },
+            "List limit records following the record after_id."
+        );
+        // After the numeric list commands, which reject "list --format"
+        insertRecordCommands(*menu, db);
+        menu->Insert(
+            "search",
+            [&](std::ostream &ostream, const std::vector<std::string> &terms) {
+                std::string query;
+                for (const auto &term: terms) {
+                    query += term + ' ';
                 }
+                print_records(ostream, db.Search(query, kSearchLimit));
             },
-            "Get a record by a person's first and last name."
-            );
+            "Search records by the beginnings of words in any field, "
+            "e.g. \"search pet park\"."
+        );
         menu->Insert(
-            "delete",
-            { "id" },
-            [&](std::ostream& os, int id) {
-                int rows_affected = db.DeleteRecord(id);
-                if (rows_affected == 0) {
-                    os << "Record #" << id << " does not exist." << '\n';
+            "delete_many",
+            [&](std::ostream& os, const std::vector<std::string>& params) {
+                std::vector<int> ids;
+                for (const auto &param: params) {
+                    int id = parse_id(param);
+                    if (id < 0) {
+                        os << "\"" << param << "\" is not a record id. Nothing done." << std::endl;
+                        return;
+                    }
+                    ids.push_back(id);
                 }
-                os << rows_affected << " rows affected." << std::endl;
+                print_batches(os, db.DeleteRecords(ids));
             },
-            "Deletes a record by its id."
+            "Deletes records by their ids, e.g. \"delete_many 1 2 3\"."
         );
         menu->Insert(
             "delete_by_name",
@@ -144,6 +754,22 @@ int main(int argc, char** argv) {
             },
             "Delete records by the details of the record."
         );
+        menu->Insert(
+            "dupes",
+            [&](std::ostream &ostream) {
+                print_duplicates(ostream, db, DedupeOptions().threshold);
+            },
+            "List pairs of records that likely describe the same contact."
+        );
+        menu->Insert(
+            "dupes",
+            {"threshold"},
+            [&](std::ostream &ostream, double threshold) {
+                print_duplicates(ostream, db, threshold);
+            },
+            "List pairs of records scoring at least threshold (0 to 1) "
+            "as the same contact."
+        );
         menu->Insert(
             "update",
             {"id", "first-name", "last-name", "email", "telephone"},
@@ -167,25 +793,121 @@ int main(int argc, char** argv) {
             "Update the record by its id."
         );
         menu->Insert(
-            "clear",
-            {"confirmation"},
-            [&](std::ostream& os, const std::string &confirmation) {
-                std::string up_string(confirmation);
-                std::transform(
-                    up_string.begin(),
-                    up_string.end(),
-                    up_string.begin(),
-                    ::toupper
-                );
-                if (up_string == "YES") {
-                    db.ClearRecords();
-                    os << "All data cleared." << std::endl;
+            "update_many",
+            [&](std::ostream& ostream, const std::vector<std::string>& params) {
+                if (params.empty() || params.size() % 5 != 0) {
+                    ostream << "Expected groups of id, first-name, last-name, "
+                        "email, telephone. Nothing done." << std::endl;
+                    return;
+                }
+                std::vector<std::pair<int, Record>> updates;
+                for (std::size_t i = 0; i < params.size(); i += 5) {
+                    int rowid = parse_id(params[i]);
+                    if (rowid < 0) {
+                        ostream << "\"" << params[i] << "\" is not a record id. Nothing done." << std::endl;
+                        return;
+                    }
+                    std::vector<std::string> fields(
+                        params.begin() + i + 1, params.begin() + i + 5);
+                    updates.emplace_back(rowid, Record(fields));
+                }
+                print_batches(ostream, db.UpdateRecords(updates));
+            },
+            "Update records by their ids, given as groups of "
+            "id, first-name, last-name, email, telephone."
+        );
+        menu->Insert(
+            "changes",
+            {"sequence"},
+            [&](std::ostream& os, long long sequence) {
+                print_changes(os, db, sequence);
+            },
+            "List the changes made after the change numbered sequence, "
+            "0 for all."
+        );
+        menu->Insert(
+            "compact_changes",
+            {"sequence"},
+            [&](std::ostream& os, long long sequence) {
+                os << db.CompactChanges(sequence) << " changes removed."
+                   << std::endl;
+            },
+            "Remove the changes up to the change numbered sequence, once "
+            "every mirror has read them."
+        );
+        menu->Insert(
+            "begin",
+            [&](std::ostream& os) {
+                transactions.push_back(std::make_unique<Database::Transaction>(db));
+                os << "Transaction " << transactions.size() << " opened." << std::endl;
+            },
+            "Open a transaction, nested in the current one if any. "
+            "Changes are only saved by \"commit\"."
+        );
+        menu->Insert(
+            "commit",
+            [&](std::ostream& os) {
+                if (transactions.empty()) {
+                    os << "No transaction is open." << std::endl;
+                    return;
+                }
+                transactions.back()->Commit();
+                transactions.pop_back();
+                os << "Transaction " << transactions.size() + 1 << " committed." << std::endl;
+            },
+            "Commit the innermost open transaction."
+        );
+        menu->Insert(
+            "rollback",
+            [&](std::ostream& os) {
+                if (transactions.empty()) {
+                    os << "No transaction is open." << std::endl;
+                    return;
+                }
+                transactions.back()->Rollback();
+                transactions.pop_back();
+                os << "Transaction " << transactions.size() + 1 << " rolled back." << std::endl;
+            },
+            "Discard the changes of the innermost open transaction."
+        );
+        menu->Insert(
+            "cache_stats",
+            [&](std::ostream& os) {
+                CacheStats stats = db.GetCacheStats();
+                if (stats.byte_budget == 0) {
+                    os << "The record cache is disabled." << std::endl;
+                    return;
                 }
-                else {
-                    os << "Type \"yes\" to confirm removing all data in the database." << std::endl;
+                os << "Hits: " << stats.hits << '\n'
+                   << "Misses: " << stats.misses << '\n'
+                   << "Evictions: " << stats.evictions << '\n'
+                   << "Entries: " << stats.entries << '\n'
+                   << "Bytes: " << stats.bytes << " / " << stats.byte_budget
+                   << std::endl;
+            },
+            "Show the counters of the record cache."
+        );
+        menu->Insert(
+            "stats",
+            [&](std::ostream& os) {
+                os << db.GetMetrics();
+                os.flush();
+            },
+            "Show the statement metrics, if enabled in config.json, and the "
+            "page cache counters."
+        );
+        menu->Insert(
+            "stats",
+            {"format"},
+            [&](std::ostream& os, const std::string& format) {
+                if (format != "json") {
+                    os << "Unknown format \"" << format
+                       << "\", expected \"json\"." << std::endl;
+                    return;
                 }
+                os << db.GetMetrics().ToJson() << std::endl;
             },
-            "Deletes all records the database. Use \"yes\" to confirm the change."
+            "Show the metrics as JSON."
         );
         cli::Cli mycli(std::move(menu));
         cli::CliFileSession file_session(mycli);